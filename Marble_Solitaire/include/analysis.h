@@ -0,0 +1,81 @@
+#ifndef ANALYSIS_H
+#define ANALYSIS_H
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include "bitboard.h"
+#include "opening_book.h"
+#include "rules.h"
+#include "solvability_db.h"
+#include "solver.h"
+
+enum Solvability
+{
+	SOLVABILITY_UNKNOWN, // Not analysed yet, or the time budget ran out
+	WINNABLE,
+	NOT_WINNABLE
+};
+
+struct Analysis
+{
+	Bitboard board;			 // Position the result belongs to
+	Solvability solvability;
+	bool hasMove;			 // bestMove is set: a move that keeps the game winnable
+	Move bestMove;
+};
+
+/*
+	Solves positions on a background thread so the render loop never waits.
+	Each request cancels the one in flight; only the most recent request is
+	ever answered. Results are picked up by polling, which takes a lock for
+	a few instructions and never blocks on the search itself.
+*/
+class AnalysisWorker
+{
+public:
+	// Searches giving up after 'timeBudget' seconds report SOLVABILITY_UNKNOWN
+	explicit AnalysisWorker(double timeBudget);
+	~AnalysisWorker();
+
+	// Analyse 'board', abandoning any earlier request; hopeless classes and book positions are answered at once
+	void request(Bitboard board);
+
+	// Abandon the current request without starting another
+	void cancel();
+
+	// The latest finished analysis; false if none has finished since the last request
+	bool poll(Analysis &result);
+
+	// Answer from this database instead of searching while it is loaded (set before requesting)
+	void setDatabase(const SolvabilityDatabase *database);
+
+	// Let the search finish small positions from this tablebase (set before requesting)
+	void setTablebase(const EndgameTablebase *tablebase);
+
+	// Answer opening positions from this book without waking the thread
+	void setOpeningBook(const OpeningBook *book);
+
+private:
+	void run();
+	bool lookup(Bitboard board, Analysis &analysis) const;
+
+	Solver solver;
+	const SolvabilityDatabase *database;
+	const OpeningBook *book;
+	std::thread thread;
+	std::mutex lock;
+	std::condition_variable wake;
+	std::atomic<bool> cancelFlag;
+
+	bool quit;
+	bool pending;		// A request is waiting to be picked up
+	Bitboard requested;
+	unsigned generation; // Bumped by every request and cancel
+	bool ready;
+	Analysis latest;
+};
+
+#endif
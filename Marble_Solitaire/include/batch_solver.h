@@ -0,0 +1,63 @@
+#ifndef BATCH_SOLVER_H
+#define BATCH_SOLVER_H
+
+#include <vector>
+
+#include "bitboard.h"
+#include "endgame_tablebase.h"
+#include "pagoda.h"
+
+/*
+	Solves for every finishing hole at once: the result for a position is
+	the set of holes it can be reduced to a single marble on, the union of
+	its children's sets. Results are remembered by canonical form, stored in
+	the canonical orientation and carried back through the inverse symmetry,
+	so one table serves every start, every target and all eight copies of
+	each position.
+
+	A position's set can never exceed what its class and the pagoda
+	functions allow, so its children stop being searched as soon as every
+	allowed hole has been found.
+*/
+class BatchSolver
+{
+public:
+	explicit BatchSolver(int tableBits = 23);
+
+	// Holes 'board' can finish on with a single marble; 0 if it cannot be won at all
+	Bitboard finishes(Bitboard board);
+
+	/*
+		For every hole h, reachable[h] receives the finishes of the start with
+		only h empty (indexed by bit number; entries for non-holes are 0).
+	*/
+	void solveSingleVacancies(Bitboard reachable[BOARD_SIZE * BOARD_STRIDE]);
+
+	// Probe this tablebase (NULL for none) to cut positions lost everywhere
+	void setTablebase(const EndgameTablebase *tablebase);
+
+	// Positions visited since construction or the last clear
+	uint64_t nodes() const;
+
+	void clear();
+
+private:
+	// A canonical board and its finishes in the canonical orientation
+	struct Entry
+	{
+		Bitboard board;
+		Bitboard finishes;
+	};
+
+	Bitboard search(Bitboard board, PagodaValues pagoda);
+	const Entry *find(Bitboard canonical, uint64_t hash) const;
+	void insert(Bitboard canonical, uint64_t hash, Bitboard finishes);
+
+	std::vector<Entry> table; // board 0 marks an empty slot
+	uint64_t mask;
+	const EndgameTablebase *tablebase;
+	int tablebaseMarbles;
+	uint64_t nodeCount;
+};
+
+#endif
@@ -0,0 +1,142 @@
+#ifndef BITBOARD_H
+#define BITBOARD_H
+
+#include <stdint.h>
+
+/*
+	A whole board position packed into one 64-bit word. Bit (row * 8 + col)
+	is set when that hole holds a marble. Rows are 8 bits wide although the
+	board is only 7 wide: the spare eighth column is never a hole, so a jump
+	shifted off the right edge of one row can never land in the next one.
+*/
+typedef uint64_t Bitboard;
+
+const int BOARD_SIZE = 7;
+const int BOARD_STRIDE = 8;
+
+// The 33 holes of the English cross: 3 wide in the arms, 7 wide in the middle
+const Bitboard ARM_ROW = 0x1CULL;
+const Bitboard FULL_ROW = 0x7FULL;
+const Bitboard VALID_HOLES = ARM_ROW | (ARM_ROW << 8) |
+							 (FULL_ROW << 16) | (FULL_ROW << 24) | (FULL_ROW << 32) |
+							 (ARM_ROW << 40) | (ARM_ROW << 48);
+
+const Bitboard CENTER_HOLE = 1ULL << (3 * BOARD_STRIDE + 3);
+
+// Every hole filled except the center
+const Bitboard START_POSITION = VALID_HOLES & ~CENTER_HOLE;
+
+inline int cellIndex(int row, int col)
+{
+	return row * BOARD_STRIDE + col;
+}
+
+inline Bitboard cellBit(int row, int col)
+{
+	return 1ULL << cellIndex(row, col);
+}
+
+inline bool isBoardHole(int row, int col)
+{
+	if (row < 0 || row >= BOARD_SIZE || col < 0 || col >= BOARD_SIZE)
+		return false;
+
+	return (VALID_HOLES & cellBit(row, col)) != 0;
+}
+
+inline bool hasMarble(Bitboard board, int row, int col)
+{
+	return (board & cellBit(row, col)) != 0;
+}
+
+inline int countMarbles(Bitboard board)
+{
+	return __builtin_popcountll(board);
+}
+
+enum Direction
+{
+	DIR_UP,
+	DIR_DOWN,
+	DIR_LEFT,
+	DIR_RIGHT,
+	DIR_COUNT
+};
+
+// Bit offset of a single step in each direction
+const int DIRECTION_STEP[DIR_COUNT] = {-BOARD_STRIDE, BOARD_STRIDE, -1, 1};
+
+// For each direction, the holes a marble can legally jump from
+struct MoveMasks
+{
+	Bitboard from[DIR_COUNT];
+};
+
+/*
+	Bulk legal-move generation. A jump from bit i in a direction with step s
+	needs a marble at i, a marble at i + s and an empty hole at i + 2s, so
+	shifting the board and the empty set back onto the origin square yields
+	every legal origin for that direction at once.
+*/
+inline void generateMoves(Bitboard board, MoveMasks &moves)
+{
+	Bitboard empty = VALID_HOLES & ~board;
+
+	moves.from[DIR_UP] = board & (board << 8) & (empty << 16);
+	moves.from[DIR_DOWN] = board & (board >> 8) & (empty >> 16);
+	moves.from[DIR_LEFT] = board & (board << 1) & (empty << 2);
+	moves.from[DIR_RIGHT] = board & (board >> 1) & (empty >> 2);
+}
+
+inline bool hasAnyMove(Bitboard board)
+{
+	MoveMasks moves;
+	generateMoves(board, moves);
+
+	return (moves.from[DIR_UP] | moves.from[DIR_DOWN] | moves.from[DIR_LEFT] | moves.from[DIR_RIGHT]) != 0;
+}
+
+inline int countMoves(const MoveMasks &moves)
+{
+	return countMarbles(moves.from[DIR_UP]) + countMarbles(moves.from[DIR_DOWN]) +
+		   countMarbles(moves.from[DIR_LEFT]) + countMarbles(moves.from[DIR_RIGHT]);
+}
+
+// The three holes toggled by jumping from bit index 'from' in direction 'dir'
+inline Bitboard jumpMask(int from, int dir)
+{
+	int step = DIRECTION_STEP[dir];
+	return (1ULL << from) | (1ULL << (from + step)) | (1ULL << (from + 2 * step));
+}
+
+/*
+	A jump in one byte: the origin's bit index (below 56, so 6 bits) shifted
+	left twice, plus the direction. The jumped-over and landing holes follow
+	from those two, so they are never stored.
+*/
+typedef uint8_t MoveCode;
+
+// Longest possible game: a board with a legal move holds at most 32 marbles, and every jump removes one
+const int MAX_GAME_MOVES = 31;
+
+inline MoveCode encodeJump(int from, int dir)
+{
+	return static_cast<MoveCode>(from << 2 | dir);
+}
+
+inline int jumpOrigin(MoveCode code)
+{
+	return code >> 2;
+}
+
+inline int jumpDirection(MoveCode code)
+{
+	return code & 3;
+}
+
+inline Bitboard jumpMask(MoveCode code)
+{
+	return jumpMask(jumpOrigin(code), jumpDirection(code));
+}
+
+#endif
@@ -0,0 +1,19 @@
+#ifndef BOARD_LAYOUT_H
+#define BOARD_LAYOUT_H
+
+#include "rules.h"
+
+/*
+	Where the holes sit on screen. The board is drawn in world units with an
+	orthographic projection one unit tall, centred on the center hole, so
+	the mapping from a window pixel to a hole needs only the window size and
+	is shared by the renderer, input handling and the benchmarks.
+*/
+
+const float SQUARE_SIZE = 0.1f;				   // Half-width of one cell's square
+const float CELL_SPACING = SQUARE_SIZE * 2.2f; // Distance between neighbouring hole centres
+
+// The hole under window pixel (xpos, ypos), or {-1, -1} if there is none
+Position screenToBoard(double xpos, double ypos, int windowWidth, int windowHeight);
+
+#endif
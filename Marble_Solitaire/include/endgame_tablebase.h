@@ -0,0 +1,66 @@
+#ifndef ENDGAME_TABLEBASE_H
+#define ENDGAME_TABLEBASE_H
+
+#include <stdio.h>
+
+#include "bitboard.h"
+
+/*
+	Win/loss for every arrangement of up to N marbles on the 33 holes,
+	reachable from the standard start or not. Each jump removes exactly one
+	marble, so a won position with k marbles is always won in k - 1 moves:
+	one bit per position is the whole answer, distance included.
+
+	Positions are indexed densely: the 33 holes are packed into a 33-bit
+	word and each k-marble layer ranks its combinations in colex order, so
+	a probe is a handful of table lookups and one bit test on the
+	memory-mapped file.
+*/
+class EndgameTablebase
+{
+public:
+	EndgameTablebase();
+	~EndgameTablebase();
+
+	// Map the file; false (with a message on stderr) if it is missing or malformed
+	bool open(const char *fileName);
+	void close();
+
+	bool isLoaded() const;
+
+	// Largest marble count stored, 0 when nothing is loaded
+	int maxMarbles() const;
+
+	// True if 'board' is small enough to have an entry
+	bool covers(Bitboard board) const;
+
+	// Can 'board' be reduced to a single marble anywhere? Only meaningful when covers(board)
+	bool isWinnable(Bitboard board) const;
+
+	// Distance to a single marble for a covered, winnable position
+	static int movesToWin(Bitboard board);
+
+	/*
+		Write a winning line for a covered, winnable position into 'line' by
+		always stepping to a winnable successor; returns its length, or -1 if
+		the position is not covered or not winnable.
+	*/
+	int winningLine(Bitboard board, MoveCode *line) const;
+
+private:
+	void *mapping;
+	size_t mappingSize;
+	int marbleLimit;
+	const uint64_t *layers[BOARD_SIZE * BOARD_SIZE]; // Bit array of each marble count
+};
+
+const int DEFAULT_TABLEBASE_MARBLES = 10;
+
+/*
+	Build the layers from one marble upward: a k-marble position is won if
+	some jump leads to a won (k - 1)-marble position. Progress goes to
+	'log'.
+*/
+bool buildEndgameTablebase(const char *fileName, int maxMarbles, FILE *log);
+
+#endif
@@ -0,0 +1,98 @@
+#ifndef GAME_H
+#define GAME_H
+
+#include "bitboard.h"
+#include "pagoda.h"
+#include "rules.h"
+
+#include <vector>
+
+/*
+	One game in progress: the position, its outcome and the undo/redo
+	history. Built on the pure rules core and free of any UI state, so
+	several games can live side by side (one per thread, say).
+
+	The history is a tree: undoing and playing a different move starts a
+	new variation instead of discarding the old line. The arrays below are
+	the current line, the path from the start through the currently chosen
+	child at every node, and are rebuilt from the tree only where it
+	changes.
+*/
+class Game
+{
+public:
+	Bitboard board;
+	uint64_t hash; // Zobrist hash of board, kept up to date move by move
+	GameStatus status;
+	int remainingMarbles;
+	MoveMasks legalMoves; // Kept in step with board by every move, undo and redo
+	int legalMoveCount;
+	PagodaValues pagoda; // Pagoda function sums of board, updated like legalMoves
+	MoveCode moveHistory[MAX_GAME_MOVES]; // Fixed capacity: no game is longer
+	int historyLength;					  // Moves on the current line, including undone ones that can be redone
+	int currentMoveIndex;				  // For undo/redo functionality
+
+	// positions[n] is the board after n moves, so any point in the history is one load away
+	Bitboard positions[MAX_GAME_MOVES + 1];
+	int lineNodes[MAX_GAME_MOVES + 1]; // Tree node reached after n moves on the current line
+
+	Game();
+
+	// Back to the standard start: every hole filled except the center
+	void reset();
+
+	// Play a jump; on an illegal move the game is unchanged and the reason is returned
+	MoveError makeMove(Position from, Position to);
+
+	/*
+		True when the class invariant and the pagoda functions already prove
+		that no single marble can be left, however many moves remain. A cheap early verdict: false does
+		not mean the position can still be won.
+	*/
+	bool isProvablyLost() const;
+
+	bool canUndo() const;
+	bool canRedo() const;
+
+	// Step one move back or forward through the history; false if there is none
+	bool undoMove();
+	bool redoMove();
+
+	// Number of moves currently played, from 0 up to historyLength
+	int currentPly() const;
+
+	// Jump straight to the position after 'ply' moves, keeping the history; false if out of range
+	bool goToMove(int ply);
+	bool undoAll();
+	bool redoAll();
+
+	// The moves already explored from the current position, in the order they were first played
+	int variationCount() const;
+	MoveCode variation(int index) const;
+
+	// Which explored move redo follows from here; -1 at the end of a line
+	int activeVariation() const;
+
+	// Make another explored move the continuation of the current line; false if there is no such index
+	bool selectVariation(int index);
+
+private:
+	// One explored move; children are chained through nextSibling
+	struct VariationNode
+	{
+		int firstChild;
+		int nextSibling;
+		int chosenChild; // Continuation redo follows, the most recently played or selected
+		MoveCode move;
+	};
+
+	std::vector<VariationNode> tree; // Node 0 is the start position; capacity reserved up front
+
+	GameStatus statusFromCounts() const;
+	void loadPosition(Bitboard position);
+	int childAt(int node, int index) const;
+	int findOrAddChild(int node, MoveCode move);
+	void extendLine(int ply);
+};
+
+#endif
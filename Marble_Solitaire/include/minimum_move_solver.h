@@ -0,0 +1,118 @@
+#ifndef MINIMUM_MOVE_SOLVER_H
+#define MINIMUM_MOVE_SOLVER_H
+
+#include <chrono>
+#include <functional>
+#include <vector>
+
+#include "bitboard.h"
+#include "endgame_tablebase.h"
+#include "pagoda.h"
+#include "pattern_database.h"
+#include "rules.h"
+
+// Where a minimum-move search has got to, reported as it runs
+struct MinimumMoveProgress
+{
+	int bound;		// Moves the current iteration allows; every shorter solution is ruled out
+	uint64_t nodes; // Positions visited so far
+	double seconds;
+};
+
+typedef std::function<void(const MinimumMoveProgress &)> MinimumMoveCallback;
+
+/*
+	Finds a solution with the fewest moves, where a move is any number of
+	consecutive jumps by the same marble (the classic 18-move solution of
+	the standard start counts this way). The state is the board plus the
+	hole the last jump landed on: jumps continuing from there are free, any
+	other jump starts a new move.
+
+	Iterative-deepening A*: each iteration searches depth-first while moves
+	made plus a lower bound on moves still needed stay within the limit,
+	then raises the limit to the smallest total that exceeded it. The bound
+	is admissible, so the first solution found is optimal. With pattern
+	databases loaded, the bound is the larger of the corner count and the
+	sum of the region costs. A transposition
+	table remembers the best proven bound of each (canonical) state between
+	iterations.
+*/
+class MinimumMoveSolver
+{
+public:
+	explicit MinimumMoveSolver(int tableBits = 22);
+
+	/*
+		Fewest moves from 'board' to a single marble (on 'target' if given),
+		with the jumps of one optimal solution in 'jumps'; -1 if the position
+		cannot be won or the node budget ran out (see aborted()).
+	*/
+	int solve(Bitboard board, std::vector<Move> &jumps, Bitboard target = 0);
+
+	// Give up after this many positions (0 for no limit)
+	void setNodeBudget(uint64_t nodes);
+
+	// Called at the start of every iteration and every PROGRESS_INTERVAL positions
+	void setProgressCallback(const MinimumMoveCallback &callback);
+
+	// Probe this tablebase (NULL for none) to cut positions lost everywhere
+	void setTablebase(const EndgameTablebase *tablebase);
+
+	// Strengthen the bound with these pattern databases (NULL for none)
+	void setPatternDatabase(const PatternDatabase *patterns);
+
+	// The budget ran out; bound() is then the best lower bound proven
+	bool aborted() const;
+	int bound() const;
+
+	uint64_t nodes() const;
+
+	/*
+		Admissible estimate of the moves 'board' still needs when the last
+		jump landed on bit 'last' (-1 for none). A marble on one of the eight
+		corner holes can never be jumped over, so it must make a jump of its
+		own: every occupied corner costs a move, except for the marble that
+		can continue its chain for free and one that may stay as the last.
+	*/
+	static int lowerBound(Bitboard board, int last, Bitboard target);
+
+	static const uint64_t PROGRESS_INTERVAL = 1 << 22;
+
+private:
+	struct Entry
+	{
+		uint64_t key; // Canonical board, with the last landing hole + 1 in the top byte
+		int32_t bound;
+	};
+
+	int estimate(Bitboard board, int last) const;
+	int search(Bitboard board, int last, PagodaValues pagoda, int made, int depth);
+	uint64_t stateKey(Bitboard board, int last) const;
+	int storedBound(uint64_t key, uint64_t hash) const;
+	void storeBound(uint64_t key, uint64_t hash, int bound);
+	void reportProgress();
+
+	std::vector<Entry> table; // key 0 marks an empty slot
+	uint64_t mask;
+
+	Bitboard target;
+	Bitboard finishes; // Holes the last marble may end on: the target, or any hole in the start's class
+	bool canonicalKeys;
+	int threshold;
+	bool found;
+	int solutionMoves;
+
+	const EndgameTablebase *tablebase;
+	int tablebaseMarbles;
+	const PatternDatabase *patterns;
+
+	uint64_t budget;
+	uint64_t nodeCount;
+	bool stopped;
+	MinimumMoveCallback callback;
+	std::chrono::steady_clock::time_point start;
+
+	MoveCode line[MAX_GAME_MOVES];
+};
+
+#endif
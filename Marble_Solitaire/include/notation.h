@@ -0,0 +1,26 @@
+#ifndef NOTATION_H
+#define NOTATION_H
+
+#include <string>
+
+#include "bitboard.h"
+#include "rules.h"
+
+/*
+	Text form of a position for command-line tools: the 33 holes in reading
+	order, 'o' for a marble and '.' for an empty hole, rows separated by '/':
+
+		ooo/ooo/ooooooo/ooo.ooo/ooooooo/ooo/ooo
+
+	A raw bitboard in hex ("0x1c1c7f777f1c1c") is accepted as well.
+*/
+
+std::string formatBoard(Bitboard board);
+
+// False if 'text' is not a valid position
+bool parseBoard(const std::string &text, Bitboard &board);
+
+// Move as "r,c-r,c", rows and columns counted from 0 at the top left
+std::string formatMove(const Move &move);
+
+#endif
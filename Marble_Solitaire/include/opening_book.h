@@ -0,0 +1,59 @@
+#ifndef OPENING_BOOK_H
+#define OPENING_BOOK_H
+
+#include <stdio.h>
+#include <vector>
+
+#include "bitboard.h"
+#include "endgame_tablebase.h"
+#include "rules.h"
+
+/*
+	Every position within the first few plies of the standard start and of
+	each single-vacancy start, stored by canonical form with its verdict
+	(won down to one marble anywhere, or not) and a winning move. Moves are
+	kept in the canonical orientation and mapped back through the inverse
+	symmetry on lookup, so the eight copies of a position share one entry.
+
+	The file is small (a sorted array of 8-byte entries) and is read into
+	memory whole; a lookup is one canonicalisation and a binary search.
+*/
+class OpeningBook
+{
+public:
+	OpeningBook();
+
+	// Read the file; false (with a message on stderr) if it is missing or malformed
+	bool open(const char *fileName);
+	void close();
+
+	bool isLoaded() const;
+
+	// Deepest ply stored, counted from a start position
+	int plies() const;
+
+	// Number of canonical positions stored
+	size_t size() const;
+
+	/*
+		True if 'board' is in the book. 'winnable' receives the verdict and,
+		for a winnable position, 'bestMove' a move that keeps it winnable, in
+		the orientation of 'board'.
+	*/
+	bool lookup(Bitboard board, bool &winnable, Move &bestMove) const;
+
+private:
+	std::vector<uint64_t> entries; // Canonical board in the low bits, move code (or BOOK_LOST) in the top byte
+	int depth;
+};
+
+const int DEFAULT_BOOK_PLIES = 5;
+
+/*
+	Expand the starts ply by ply, solve the deepest ply with the search
+	(probing 'tablebase' if it is not NULL), then settle each shallower ply
+	from the one below it. Progress goes to 'log'.
+*/
+bool buildOpeningBook(const char *fileName, int plies, const EndgameTablebase *tablebase, FILE *log);
+
+#endif
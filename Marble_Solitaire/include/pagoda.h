@@ -0,0 +1,81 @@
+#ifndef PAGODA_H
+#define PAGODA_H
+
+#include "bitboard.h"
+
+/*
+	Pagoda functions: a weight per hole such that, for every jump from a
+	over b onto c, w(c) <= w(a) + w(b). The weighted sum of a position's
+	marbles can then never grow, so a position whose sum is already below
+	w(h) can never be reduced to a single marble on h.
+
+	PAGODA_COUNT fixed weightings are kept side by side in one 64-bit word,
+	one byte lane each, holding the sum plus PAGODA_BIAS so that it is never
+	negative. A jump only ever lowers every lane, so a child's values are its
+	parent's minus one precomputed word: no carries cross between lanes.
+*/
+
+const int PAGODA_COUNT = 8;
+const int PAGODA_BIAS = 64;
+
+// Weight of each hole in each function, rows and columns as on the board
+extern const int8_t PAGODA_WEIGHTS[PAGODA_COUNT][BOARD_SIZE][BOARD_SIZE];
+
+typedef uint64_t PagodaValues;
+
+/*
+	Tables derived from the weights: each hole's weights, how much each lane
+	drops for a jump from bit index 'from' in direction 'dir', and for every
+	function and every lane value the holes whose weight does not exceed it.
+*/
+struct PagodaTables
+{
+	PagodaValues hole[64];
+	PagodaValues drop[DIR_COUNT][64];
+	Bitboard reachable[PAGODA_COUNT][256];
+
+	PagodaTables();
+
+	// Signed weight of function k stored in a per-hole word
+	static int lane(PagodaValues values, int k)
+	{
+		return static_cast<int8_t>(values >> (8 * k));
+	}
+};
+
+/*
+	Built by the first caller, whichever function that is, rather than
+	during static initialisation, so nothing can see the tables unfilled.
+	Inline, so the hot jump update pays only the initialised-yet check.
+*/
+inline const PagodaTables &pagodaTables()
+{
+	static const PagodaTables tables;
+	return tables;
+}
+
+PagodaValues pagodaValues(Bitboard board);
+
+inline PagodaValues pagodaJump(PagodaValues values, int from, int dir)
+{
+	return values - pagodaTables().drop[dir][from];
+}
+
+// Values before the jump, given the values after it
+inline PagodaValues pagodaUndo(PagodaValues values, int from, int dir)
+{
+	return values + pagodaTables().drop[dir][from];
+}
+
+/*
+	The holes a position with these values might still finish on with a
+	single marble. Every other hole is ruled out by at least one function;
+	an empty answer (given the holes it must finish on) proves the position
+	lost.
+*/
+Bitboard pagodaFinishes(PagodaValues values);
+
+// True if each function in PAGODA_WEIGHTS satisfies the pagoda condition for every jump
+bool verifyPagodaWeights();
+
+#endif
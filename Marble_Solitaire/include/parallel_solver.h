@@ -0,0 +1,117 @@
+#ifndef PARALLEL_SOLVER_H
+#define PARALLEL_SOLVER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "bitboard.h"
+#include "endgame_tablebase.h"
+#include "pagoda.h"
+#include "rules.h"
+
+/*
+	Transposition table shared by all solver threads without locks. Each
+	slot is a single atomic 64-bit word holding the (canonical) board, so a
+	reader can never see a torn entry: it either finds the exact board or
+	it does not.
+*/
+class AtomicTranspositionTable
+{
+public:
+	explicit AtomicTranspositionTable(int sizeBits = 23);
+
+	bool contains(Bitboard board, uint64_t hash) const;
+	void insert(Bitboard board, uint64_t hash);
+	void clear();
+
+private:
+	std::unique_ptr<std::atomic<Bitboard>[]> slots;
+	uint64_t mask;
+};
+
+/*
+	Multi-threaded version of Solver. The top 'splitDepth' plies of the move
+	tree are expanded into tasks on per-thread work queues; a thread works
+	its own queue newest-first and steals the oldest task from another queue
+	when it runs dry. Below the split depth each task is searched depth-first
+	against the shared table. The first thread to find a win stops the rest.
+	A thread with nothing to do sleeps until another one queues work.
+*/
+class ParallelSolver
+{
+public:
+	// A 'splitDepth' of 0 picks one deep enough to give every thread many tasks
+	explicit ParallelSolver(int threads, int tableBits = 23, int splitDepth = 0);
+
+	// Same contract as Solver::solve, using every thread
+	bool solve(Bitboard board, std::vector<Move> &solution, Bitboard target = 0);
+
+	/*
+		Ask a running solve, or the next one if none is running yet, to give
+		up; it then reports the position as not won. The request stays until
+		clearCancel(), so one made while a solve is starting is never lost.
+	*/
+	void cancel();
+	void clearCancel();
+	bool cancelled() const;
+
+	// Same as Solver::setTablebase; the tablebase is only read, so threads share it
+	void setTablebase(const EndgameTablebase *tablebase);
+
+	// Positions visited by the last solve, over all threads
+	uint64_t nodes() const;
+
+	int threads() const;
+
+private:
+	// A subtree root plus the jumps that led to it
+	struct Task
+	{
+		Bitboard board;
+		int depth;
+		MoveCode path[MAX_GAME_MOVES];
+	};
+
+	struct WorkQueue
+	{
+		std::mutex lock;
+		std::deque<Task> tasks;
+	};
+
+	void worker(int id);
+	bool takeTask(int id, Task &task);
+	void expandTask(int id, const Task &task, uint64_t &nodes);
+	bool search(Bitboard board, PagodaValues pagoda, int depth, MoveCode *path, uint64_t &nodes);
+	void reportWin(const MoveCode *path, int length);
+	bool halted() const;
+	void wakeIdle();
+
+	int threadCount;
+	int splitDepth;
+	AtomicTranspositionTable table;
+	std::vector<std::unique_ptr<WorkQueue> > queues;
+
+	Bitboard target;
+	Bitboard finishes; // Holes the last marble may end on: the target, or any hole in the start's class
+	bool canonicalKeys;
+	const EndgameTablebase *tablebase;
+	int tablebaseMarbles;
+	std::atomic<bool> stop;	  // A win was found: the other threads unwind; reset by every solve
+	std::atomic<bool> cancelRequested; // Set by cancel() only; solve never clears it
+	std::atomic<bool> found;
+	std::atomic<int> pending; // Tasks queued or being worked on
+	std::atomic<int> queued;  // Tasks sitting in a queue, ready to be taken
+
+	std::mutex idleLock;
+	std::condition_variable idle; // Signalled when work is queued or the solve ends
+	std::atomic<uint64_t> nodeCount;
+
+	MoveCode winningPath[MAX_GAME_MOVES];
+	int winningLength;
+};
+
+#endif
@@ -0,0 +1,74 @@
+#ifndef PATTERN_DATABASE_H
+#define PATTERN_DATABASE_H
+
+#include <stdio.h>
+
+#include "bitboard.h"
+
+/*
+	Additive pattern databases for the minimum-move search. The board is
+	cut along a diagonal into two halves of 17 and 16 holes, each two arms
+	with the center cells between them, and each half has two exact
+	tables: the fewest moves needed to empty it, and to bring it down to at
+	most one marble, when every hole outside it is a wildcard that may hold
+	a marble or not as convenient. Only one half can hold the last marble;
+	the other must be emptied. The same tables also bound the mirrored
+	board, which cuts it along the other diagonal, and the larger bound is
+	used.
+
+	The abstract state of a region is its marbles plus the hole the last
+	jump landed on, if that hole is in the region. A move is charged only to
+	the region its first jump starts from, and continuing a chain from the
+	landing hole is free, so the regions never count the same move twice and
+	their sum is still a lower bound on the real number of moves.
+
+	Tables hold one byte per state and are memory-mapped from one file of
+	about 7 MB.
+*/
+
+const int PATTERN_REGIONS = 2;
+
+// Symmetric views of the board bounded by the tables
+const int PATTERN_VIEWS = 2;
+
+// A region that can never be cleared, from which no position can be won
+const int PATTERN_DEAD = 255;
+
+class PatternDatabase
+{
+public:
+	PatternDatabase();
+	~PatternDatabase();
+
+	// Map the file; false (with a message on stderr) if it is missing or malformed
+	bool open(const char *fileName);
+	void close();
+
+	bool isLoaded() const;
+
+	/*
+		Sum of the region costs for 'board' when the last jump landed on bit
+		'last' (-1 for none): every region emptied except the one where
+		finishing is cheapest (the target's, if one is given), maximised
+		over the symmetric views. PATTERN_DEAD if that is impossible.
+	*/
+	int lowerBound(Bitboard board, int last, Bitboard target = 0) const;
+
+private:
+	// The bound for one view, with the board already transformed
+	int splitBound(Bitboard board, int last, Bitboard target) const;
+
+	void *mapping;
+	size_t mappingSize;
+	const uint8_t *emptyTables[PATTERN_REGIONS];  // Moves to clear the region
+	const uint8_t *singleTables[PATTERN_REGIONS]; // Moves to leave at most one marble in it
+};
+
+/*
+	Solve each region's abstract state space with a 0-1 BFS backwards from
+	its goal states (jumps continuing a chain cost 0, all others 1), once
+	for each goal, and write the tables. Progress goes to 'log'.
+*/
+bool buildPatternDatabase(const char *fileName, FILE *log);
+
+#endif
@@ -0,0 +1,29 @@
+#ifndef PERFT_H
+#define PERFT_H
+
+#include <stdint.h>
+
+#include "bitboard.h"
+
+/*
+	Move-generation node counting ("perft"): the number of move sequences of
+	exactly 'depth' jumps from a position, with no pruning and no
+	transposition table. Every engine change that touches move generation or
+	make/undo must leave these counts unchanged, and the time they take is
+	the standard measure of raw rules throughput.
+*/
+
+// Reference counts from the standard start, indexed by depth
+extern const uint64_t STANDARD_PERFT[];
+extern const int STANDARD_PERFT_DEPTHS;
+
+// Bulk move generation; the last ply is counted from the move masks without being played
+uint64_t perft(Bitboard board, int depth);
+
+// The same count through the rules core's move validation, hole by hole, as a cross-check
+uint64_t perftNaive(Bitboard board, int depth);
+
+// perft() split across 'threads' worker threads
+uint64_t parallelPerft(Bitboard board, int depth, int threads);
+
+#endif
@@ -0,0 +1,57 @@
+#ifndef POSITION_CLASS_H
+#define POSITION_CLASS_H
+
+#include "bitboard.h"
+
+/*
+	Colour every hole by (row + col) mod 3, and separately by (row - col)
+	mod 3. The three holes of any jump lie on one row or column, so they get
+	three different colours both ways: a jump empties two colours and fills
+	the third, flipping the parity of all three counts. The two parity
+	differences per colouring therefore never change, which splits positions
+	into 16 classes, and a position can only ever become positions of its
+	own class.
+*/
+
+const int POSITION_CLASS_COUNT = 16;
+
+// Holes with (row + col) % 3 == 0, 1, 2
+const Bitboard SUM_COLORS[3] = {0x0008102449120408ULL, 0x0010044912240810ULL, 0x0004081224491004ULL};
+
+// Holes with (row - col) mod 3 == 0, 1, 2
+const Bitboard DIFFERENCE_COLORS[3] = {0x0008041249241008ULL, 0x0004104924120804ULL, 0x0010082412490410ULL};
+
+/*
+	The single holes in each class: the only places the last marble of a
+	position in that class can end up. Seven classes have none, so no
+	position in them can be won at all; the standard start is in class 5,
+	with the center and the four arm tips.
+*/
+const Bitboard CLASS_FINISHES[POSITION_CLASS_COUNT] = {
+	0x0000000000000000ULL, 0x0000000000000000ULL, 0x0000000000000000ULL, 0x0000000000000000ULL,
+	0x0000000000000000ULL, 0x0008000049000008ULL, 0x0000001200001000ULL, 0x0000040000240000ULL,
+	0x0000000000000000ULL, 0x0000002400000400ULL, 0x0000080000490000ULL, 0x0010000012000010ULL,
+	0x0000000000000000ULL, 0x0000100000120000ULL, 0x0004000024000004ULL, 0x0000004900000800ULL,
+};
+
+inline int colorParities(Bitboard board, const Bitboard colors[3])
+{
+	int first = __builtin_popcountll(board & colors[0]);
+	int second = __builtin_popcountll(board & colors[1]);
+	int third = __builtin_popcountll(board & colors[2]);
+
+	return ((first ^ second) & 1) | ((second ^ third) & 1) << 1;
+}
+
+inline int positionClass(Bitboard board)
+{
+	return colorParities(board, SUM_COLORS) | colorParities(board, DIFFERENCE_COLORS) << 2;
+}
+
+// Holes the last marble could end on, as far as the class invariant can tell
+inline Bitboard classFinishes(Bitboard board)
+{
+	return CLASS_FINISHES[positionClass(board)];
+}
+
+#endif
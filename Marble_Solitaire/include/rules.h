@@ -0,0 +1,59 @@
+#ifndef RULES_H
+#define RULES_H
+
+#include "bitboard.h"
+
+/*
+	Pure game rules: every function takes a position and returns a result.
+	Nothing here touches globals, the clock or the window, so the same code
+	can be called from the renderer, from worker threads and from search.
+*/
+
+enum GameStatus
+{
+	PLAYING,
+	WON,
+	LOST
+};
+
+enum MoveError
+{
+	NONE,
+	NO_MARBLE_SELECTED,
+	DESTINATION_NOT_EMPTY,
+	INVALID_DISTANCE,
+	NO_MARBLE_TO_JUMP,
+	DESTINATION_OFF_BOARD
+};
+
+// position on the board
+struct Position
+{
+	int row;
+	int col;
+};
+
+struct Move
+{
+	Position from;
+	Position to;
+	Position captured; // Position of the captured marble
+};
+
+// Why moving the marble at 'from' to 'to' is illegal, or NONE if it is legal
+MoveError validateMove(Bitboard board, Position from, Position to);
+
+// Build the move record for a jump, filling in the captured position
+Move makeJump(Position from, Position to);
+
+// The three holes a move toggles; XOR-ing it onto a board plays or takes back the move
+Bitboard moveMask(const Move &move);
+
+// Convert between the full move record and its one-byte code (the move must be a jump)
+MoveCode encodeMove(const Move &move);
+Move decodeMove(MoveCode code);
+
+// Outcome of a position: WON with a single marble, LOST when stuck with more
+GameStatus evaluateStatus(Bitboard board);
+
+#endif
@@ -0,0 +1,50 @@
+#ifndef SOLVABILITY_DB_H
+#define SOLVABILITY_DB_H
+
+#include <stdio.h>
+
+#include "bitboard.h"
+
+/*
+	Every position reachable from the standard start that can still be won
+	(down to one marble anywhere), stored by canonical form. The file is
+	memory-mapped read-only: a small table of bucket offsets, indexed by the
+	top bits of the canonical hash, points into the sorted entry array, so a
+	lookup reads one bucket of one or two entries.
+
+	Only positions reachable from the standard start are covered; anything
+	else reads as not winnable.
+*/
+class SolvabilityDatabase
+{
+public:
+	SolvabilityDatabase();
+	~SolvabilityDatabase();
+
+	// Map the file; false (with a message on stderr) if it is missing or malformed
+	bool open(const char *fileName);
+	void close();
+
+	bool isLoaded() const;
+	bool isWinnable(Bitboard board) const;
+
+	// Number of winnable canonical positions stored
+	uint64_t size() const;
+
+private:
+	void *mapping;
+	size_t mappingSize;
+	int bucketBits;
+	const uint32_t *buckets;
+	const Bitboard *entries;
+	uint64_t entryCount;
+};
+
+/*
+	Enumerate every reachable position layer by layer (one layer per marble
+	count, symmetric copies merged), mark the winnable ones from the
+	one-marble layer upward and write the database. Progress goes to 'log'.
+*/
+bool buildSolvabilityDatabase(const char *fileName, FILE *log);
+
+#endif
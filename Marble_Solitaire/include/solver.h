@@ -0,0 +1,99 @@
+#ifndef SOLVER_H
+#define SOLVER_H
+
+#include <atomic>
+#include <chrono>
+#include <vector>
+
+#include "bitboard.h"
+#include "endgame_tablebase.h"
+#include "pagoda.h"
+#include "rules.h"
+
+/*
+	Positions already proven unwinnable, keyed by Zobrist hash. Slots store
+	the full board next to the hash so a collision can never turn a winnable
+	position into a "known lost" one; when a probe window is full the
+	oldest-looking entry is simply overwritten.
+*/
+class TranspositionTable
+{
+public:
+	explicit TranspositionTable(int sizeBits = 22);
+
+	bool contains(Bitboard board, uint64_t hash) const;
+	void insert(Bitboard board, uint64_t hash);
+	void clear();
+
+private:
+	std::vector<Bitboard> slots; // 0 marks an empty slot; no real position is empty
+	uint64_t mask;
+};
+
+/*
+	Exhaustive depth-first solver. A position is won when a single marble is
+	left (on 'target' if one is given, anywhere otherwise). Every position
+	that fails is remembered, so transpositions reached by a different move
+	order are cut off immediately, and positions the pagoda functions show
+	cannot finish on the target are never expanded. With an endgame
+	tablebase, positions it covers are answered by a probe instead.
+*/
+class Solver
+{
+public:
+	/*
+		Without 'useSymmetry' the table is keyed by the Zobrist hash threaded
+		through the search, one XOR per jump. With it, the table is keyed by
+		the canonical image of each position, so all eight symmetric copies
+		share one entry, but every node pays for eight board transforms and a
+		rehash: a Zobrist hash does not survive canonicalization. The saved
+		nodes (about 15-20%) do not cover that, so plain keys are the
+		default. Searches for an asymmetric target always use plain keys.
+	*/
+	explicit Solver(int tableBits = 22, bool useSymmetry = false);
+
+	// True if 'board' can still be won; the winning line is written to 'solution'
+	bool solve(Bitboard board, std::vector<Move> &solution, Bitboard target = 0);
+	bool solve(Bitboard board, Bitboard target = 0);
+
+	// Positions visited by the last solve
+	uint64_t nodes() const;
+
+	/*
+		Give up when *cancel becomes true or after 'seconds' of searching
+		(0 for no limit). An interrupted solve returns false with aborted()
+		set, and leaves the table holding only proven results.
+	*/
+	void setCancelFlag(const std::atomic<bool> *cancel);
+	void setTimeLimit(double seconds);
+	bool aborted() const;
+
+	// Probe this tablebase (NULL for none) once few enough marbles are left
+	void setTablebase(const EndgameTablebase *tablebase);
+
+	// Forget known-lost positions, e.g. before switching to a different target
+	void clear();
+
+private:
+	bool search(Bitboard board, uint64_t hash, PagodaValues pagoda, int depth);
+	bool checkAbort();
+
+	TranspositionTable table;
+	bool useSymmetry;
+	bool canonicalKeys; // useSymmetry, and the current target allows it
+	Bitboard target;
+	Bitboard finishes; // Holes the last marble may end on: the target, or any hole in the start's class
+	uint64_t nodeCount;
+
+	const EndgameTablebase *tablebase;
+	int tablebaseMarbles; // Largest marble count the tablebase answers, 0 without one
+
+	const std::atomic<bool> *cancel;
+	double timeLimit;
+	std::chrono::steady_clock::time_point deadline;
+	bool stopped;
+
+	MoveCode line[MAX_GAME_MOVES];
+};
+
+#endif
@@ -0,0 +1,142 @@
+#ifndef SYMMETRY_H
+#define SYMMETRY_H
+
+#include "bitboard.h"
+
+/*
+	The cross has the full symmetry of the square: 4 rotations, each with or
+	without a reflection. All eight are built from three bit-twiddling
+	primitives on the 8x8 word (flip rows, mirror columns, transpose), with a
+	final shift because the board only uses the top-left 7x7 corner.
+*/
+
+const int SYMMETRY_COUNT = 8;
+
+// Row r -> 6 - r: byte swap, then drop the unused eighth row
+inline Bitboard flipRows(Bitboard board)
+{
+	return __builtin_bswap64(board) >> 8;
+}
+
+// Column c -> 6 - c: reverse the bits of every byte, then drop the unused eighth column
+inline Bitboard mirrorColumns(Bitboard board)
+{
+	const Bitboard k1 = 0x5555555555555555ULL;
+	const Bitboard k2 = 0x3333333333333333ULL;
+	const Bitboard k4 = 0x0F0F0F0F0F0F0F0FULL;
+
+	board = ((board >> 1) & k1) | ((board & k1) << 1);
+	board = ((board >> 2) & k2) | ((board & k2) << 2);
+	board = ((board >> 4) & k4) | ((board & k4) << 4);
+	return board >> 1;
+}
+
+// (r, c) -> (c, r) by swapping 4x4, 2x2 and 1x1 blocks across the diagonal
+inline Bitboard transposeBoard(Bitboard board)
+{
+	const Bitboard k1 = 0x5500550055005500ULL;
+	const Bitboard k2 = 0x3333000033330000ULL;
+	const Bitboard k4 = 0x0F0F0F0F00000000ULL;
+	Bitboard t;
+
+	t = k4 & (board ^ (board << 28));
+	board ^= t ^ (t >> 28);
+	t = k2 & (board ^ (board << 14));
+	board ^= t ^ (t >> 14);
+	t = k1 & (board ^ (board << 7));
+	board ^= t ^ (t >> 7);
+	return board;
+}
+
+/*
+	Symmetry s applies, in order: mirror columns if bit 0 is set, flip rows
+	if bit 1 is set, transpose if bit 2 is set.
+*/
+inline Bitboard transformBoard(Bitboard board, int symmetry)
+{
+	if (symmetry & 1)
+		board = mirrorColumns(board);
+	if (symmetry & 2)
+		board = flipRows(board);
+	if (symmetry & 4)
+		board = transposeBoard(board);
+	return board;
+}
+
+// The symmetry that undoes 'symmetry'
+inline int inverseSymmetry(int symmetry)
+{
+	// With a transpose in the mix the mirror and flip trade places
+	if (symmetry & 4)
+		return 4 | ((symmetry & 1) << 1) | ((symmetry & 2) >> 1);
+	return symmetry;
+}
+
+// Smallest of the eight symmetric images; 'symmetry' receives the one that produced it
+inline Bitboard canonicalBoard(Bitboard board, int &symmetry)
+{
+	Bitboard images[SYMMETRY_COUNT];
+
+	images[0] = board;
+	images[1] = mirrorColumns(board);
+	images[2] = flipRows(board);
+	images[3] = flipRows(images[1]);
+	for (int i = 0; i < 4; i++)
+		images[4 + i] = transposeBoard(images[i]);
+
+	symmetry = 0;
+	for (int i = 1; i < SYMMETRY_COUNT; i++)
+	{
+		if (images[i] < images[symmetry])
+			symmetry = i;
+	}
+
+	return images[symmetry];
+}
+
+// Branch-free variant for hot loops that only need the canonical key
+inline Bitboard canonicalBoard(Bitboard board)
+{
+	Bitboard mirrored = mirrorColumns(board);
+	Bitboard flipped = flipRows(board);
+	Bitboard rotated = flipRows(mirrored);
+
+	Bitboard best = board < mirrored ? board : mirrored;
+	Bitboard other = flipped < rotated ? flipped : rotated;
+	best = best < other ? best : other;
+
+	Bitboard t0 = transposeBoard(board);
+	Bitboard t1 = transposeBoard(mirrored);
+	Bitboard t2 = transposeBoard(flipped);
+	Bitboard t3 = transposeBoard(rotated);
+
+	other = t0 < t1 ? t0 : t1;
+	best = best < other ? best : other;
+	other = t2 < t3 ? t2 : t3;
+	return best < other ? best : other;
+}
+
+// True if every symmetry maps 'board' onto itself (the empty board, the center, ...)
+inline bool isSymmetric(Bitboard board)
+{
+	return transposeBoard(board) == board && mirrorColumns(board) == board && flipRows(board) == board;
+}
+
+/*
+	Table index for a canonical board. Zobrist hashes cannot be kept
+	incrementally once a position is replaced by its canonical image, so
+	the key is mixed directly (the murmur3 finalizer).
+*/
+inline uint64_t canonicalHash(Bitboard canonical)
+{
+	uint64_t hash = canonical;
+
+	hash ^= hash >> 33;
+	hash *= 0xFF51AFD7ED558CCDULL;
+	hash ^= hash >> 33;
+	hash *= 0xC4CEB9FE1A85EC53ULL;
+	hash ^= hash >> 33;
+	return hash;
+}
+
+#endif
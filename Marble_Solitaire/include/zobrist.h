@@ -0,0 +1,34 @@
+#ifndef ZOBRIST_H
+#define ZOBRIST_H
+
+#include "bitboard.h"
+
+/*
+	Zobrist hashing: every hole gets a fixed random 64-bit key and a position
+	hashes to the XOR of the keys of its marbles. A jump flips three holes,
+	so the hash can be updated with three XORs instead of being recomputed.
+*/
+
+extern const uint64_t ZOBRIST_KEYS[64];
+
+inline uint64_t zobristHash(Bitboard board)
+{
+	uint64_t hash = 0;
+
+	while (board)
+	{
+		hash ^= ZOBRIST_KEYS[__builtin_ctzll(board)];
+		board &= board - 1;
+	}
+
+	return hash;
+}
+
+// Hash delta of a jump from bit index 'from' in direction 'dir'
+inline uint64_t zobristJump(int from, int dir)
+{
+	int step = DIRECTION_STEP[dir];
+	return ZOBRIST_KEYS[from] ^ ZOBRIST_KEYS[from + step] ^ ZOBRIST_KEYS[from + 2 * step];
+}
+
+#endif
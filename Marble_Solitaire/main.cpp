@@ -3,6 +3,7 @@
 #include <fstream>
 #include <string.h>
 #include <stdlib.h>
+#include <stddef.h>
 #include <string>
 #include <vector>
 #include <GL/glew.h>
@@ -13,6 +14,15 @@
 #include "backends/imgui_impl_opengl3.h"
 #include "file_utils.h"
 #include "math_utils.h"
+#include "bitboard.h"
+#include "rules.h"
+#include "game.h"
+#include "board_layout.h"
+#include "notation.h"
+#include "endgame_tablebase.h"
+#include "opening_book.h"
+#include "solvability_db.h"
+#include "analysis.h"
 #define GL_SILENCE_DEPRECATION
 
 using namespace std;
@@ -26,117 +36,280 @@ int theWindowPositionX = 40, theWindowPositionY = 40;
 GLuint squareVAO, squareVBO, squareEBO;
 GLuint circleVAO, circleVBO;
 GLuint highlightVAO, highlightVBO, highlightEBO;
-GLuint gmodelLocation;
+GLuint squareInstanceVBO, circleInstanceVBO, highlightInstanceVBO; // Per-instance attributes
 GLuint gProjectionLocation;
-GLuint gColorLocation;
+
+// One copy of a shape: its centre, its scale and its colour (vertex attributes 1-3)
+struct Instance
+{
+	Vector2f offset;
+	float scale;
+	Vector3f color;
+};
+
+// What the instance buffers hold, so they are rewritten only when it changes
+int squareInstanceCount = 0;
+int circleInstanceCount = 0; // Marbles, then their centre dots
+Bitboard drawnBoard = ~0ULL; // Not a real board, so the first frame uploads
+const int MAX_HIGHLIGHTS = 3; // The selection and the two ends of the hint
+Instance drawnHighlights[MAX_HIGHLIGHTS];
+int highlightInstanceCount = 0;
 
 /* Constants */
 const int ANIMATION_DELAY = 20; /* milliseconds between rendering */
 const char *pVSFileName = "shaders/shader.vs";
 const char *pFSFileName = "shaders/shader.fs";
+const char *pSolvabilityDbFileName = "data/solvability.db"; /* built by 'make database' */
+const char *pEndgameTablebaseFileName = "data/endgame.tb";   /* built by 'make tablebase' */
+const char *pOpeningBookFileName = "data/opening.book";      /* built by 'make book' */
 const int CIRCLE_SEGMENTS = 32;
 
 // Game board configuration constants
-const int BOARD_SIZE = 7;		   
-const float SQUARE_SIZE = 0.1f;	   
 const float MARBLE_RADIUS = 0.04f; 
 
-enum MarbleState
-{
-	EMPTY,
-	MARBLE
-};
-
-enum GameStatus
-{
-	PLAYING,
-	WON,
-	LOST
-};
-
-enum MoveError {
-    NONE,
-    NO_MARBLE_SELECTED,
-    DESTINATION_NOT_EMPTY,
-    INVALID_DISTANCE,
-    NO_MARBLE_TO_JUMP
-};
-
-
 // constants to indicate error
 MoveError lastMoveError = NONE;
 bool showMoveError = false;
 double moveErrorTime = 0.0;
 const double ERROR_DISPLAY_TIME = 2.0; // seconds
-
-// position on the board
-struct Position
-{
-	int row;
-	int col;
-};
-
-struct Move
-{
-	Position from;
-	Position to;
-	Position captured; // Position of the captured marble
-};
+const double SOLVE_TIME_BUDGET = 5.0;  // seconds of background search before giving up
 
 // Game state
-MarbleState board[BOARD_SIZE][BOARD_SIZE]; // Game board
-GameStatus gameStatus = PLAYING;
+Game game; // Board, outcome and move history
+SolvabilityDatabase solvabilityDb; // Optional; memory-mapped at startup if present
+EndgameTablebase endgameTablebase; // Optional as well; ends the solvers' searches early
+OpeningBook openingBook; // Optional too; answers the first plies without a search
+AnalysisWorker analysisWorker(SOLVE_TIME_BUDGET); // Background solver when there is no database
+Solvability solvability = SOLVABILITY_UNKNOWN; // Can the current position still be won?
+bool solvabilityPending = false;			   // Waiting on analysisWorker
+AnalysisWorker hintWorker(SOLVE_TIME_BUDGET);  // Finds the move shown by the Hint button
+bool hintPending = false;					   // Waiting on hintWorker
+bool hintVisible = false;					   // hintMove is highlighted on the board
+bool hintUnavailable = false;				   // The last hint found no winning move
+Move hintMove;
 Position selectedPosition = {-1, -1}; // No selection initially
-vector<Move> moveHistory;
-int currentMoveIndex = -1; // For undo/redo functionality
 float gameTime = 0.0f;
-int remainingMarbles = 0;
 bool isDragging = false;
 
 /********************************************************************
   Utility functions
  */
 
+// Re-evaluate whether the current position can still be won, without blocking the frame
+void refreshSolvability()
+{
+	solvabilityPending = false;
+
+	if (game.status != PLAYING)
+	{
+		analysisWorker.cancel();
+		solvability = game.status == WON ? WINNABLE : NOT_WINNABLE;
+	}
+	else if (game.isProvablyLost())
+	{
+		// Settled by the pagoda functions without a lookup or a search
+		analysisWorker.cancel();
+		solvability = NOT_WINNABLE;
+	}
+	else if (solvabilityDb.isLoaded())
+	{
+		solvability = solvabilityDb.isWinnable(game.board) ? WINNABLE : NOT_WINNABLE;
+	}
+	else
+	{
+		solvability = SOLVABILITY_UNKNOWN;
+		solvabilityPending = true;
+		analysisWorker.request(game.board);
+	}
+}
+
+// Pick up a finished background analysis, if it still matches the board
+void pollSolvability()
+{
+	Analysis result;
+
+	if (solvabilityPending && analysisWorker.poll(result) && result.board == game.board)
+	{
+		solvability = result.solvability;
+		solvabilityPending = false;
+	}
+}
+
+// Start looking for the best move in the background
+void requestHint()
+{
+	if (game.status != PLAYING)
+		return;
+
+	// No move can help once the pagoda functions rule out every finish
+	if (game.isProvablyLost())
+	{
+		hintVisible = false;
+		hintUnavailable = true;
+		return;
+	}
+
+	hintWorker.request(game.board);
+	hintPending = true;
+	hintVisible = false;
+	hintUnavailable = false;
+}
+
+// The board changed: any hint, shown or still being searched, is stale
+void clearHint()
+{
+	if (hintPending)
+		hintWorker.cancel();
+
+	hintPending = false;
+	hintVisible = false;
+	hintUnavailable = false;
+}
+
+void pollHint()
+{
+	Analysis result;
+
+	if (hintPending && hintWorker.poll(result) && result.board == game.board)
+	{
+		hintPending = false;
+		hintVisible = result.hasMove;
+		hintUnavailable = !result.hasMove;
+		hintMove = result.bestMove;
+	}
+}
+
 void initializeBoard()
 {
-	//reset remaining marbles counter
-	remainingMarbles = 0;
+	clearHint();
+	game.reset();
+	gameTime = 0.0f;
+	refreshSolvability();
+}
+
+// Attach an instance buffer to 'vao'; its attributes advance once per instance, not per vertex
+static void createInstanceBuffer(GLuint vao, GLuint &instanceVBO)
+{
+	glBindVertexArray(vao);
+
+	glGenBuffers(1, &instanceVBO);
+	glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+
+	glEnableVertexAttribArray(1);
+	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(Instance), (void *)offsetof(Instance, offset));
+	glVertexAttribDivisor(1, 1);
+
+	glEnableVertexAttribArray(2);
+	glVertexAttribPointer(2, 1, GL_FLOAT, GL_FALSE, sizeof(Instance), (void *)offsetof(Instance, scale));
+	glVertexAttribDivisor(2, 1);
+
+	glEnableVertexAttribArray(3);
+	glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(Instance), (void *)offsetof(Instance, color));
+	glVertexAttribDivisor(3, 1);
+
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+static Instance makeInstance(int row, int col, float scale, float r, float g, float b)
+{
+	Instance instance;
+	instance.offset = Vector2f((col - BOARD_SIZE / 2) * CELL_SPACING, (BOARD_SIZE / 2 - row) * CELL_SPACING);
+	instance.scale = scale;
+	instance.color = Vector3f(r, g, b);
+	return instance;
+}
+
+static void uploadInstances(GLuint instanceVBO, const std::vector<Instance> &instances, GLenum usage)
+{
+	glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+	glBufferData(GL_ARRAY_BUFFER, instances.size() * sizeof(Instance), instances.empty() ? NULL : &instances[0], usage);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+// Draw the first 'count' instances already in the VAO's instance buffer with one call
+static void drawInstances(GLuint vao, GLsizei indexCount, int count)
+{
+	if (count == 0)
+		return;
+
+	glBindVertexArray(vao);
+	glDrawElementsInstanced(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, 0, count);
+	glBindVertexArray(0);
+}
+
+// The cells never move: upload one square per hole once, at startup
+static void uploadCellInstances()
+{
+	std::vector<Instance> squares;
 
 	for (int i = 0; i < BOARD_SIZE; i++)
-	{
 		for (int j = 0; j < BOARD_SIZE; j++)
-		{
-			board[i][j] = EMPTY;
-		}
+			if (isBoardHole(i, j))
+				squares.push_back(makeInstance(i, j, SQUARE_SIZE, 0.5f, 0.5f, 0.5f));
+
+	uploadInstances(squareInstanceVBO, squares, GL_STATIC_DRAW);
+	squareInstanceCount = squares.size();
+}
+
+// Rewrite the marble instances only when the board differs from the one last uploaded
+static void updateMarbleInstances()
+{
+	if (game.board == drawnBoard)
+		return;
+
+	std::vector<Instance> circles;
+
+	for (Bitboard marbles = game.board; marbles; marbles &= marbles - 1)
+	{
+		int bit = __builtin_ctzll(marbles);
+		circles.push_back(makeInstance(bit / BOARD_STRIDE, bit % BOARD_STRIDE, MARBLE_RADIUS, 0.8f, 0.2f, 0.2f));
 	}
 
-	for (int i = 0; i < BOARD_SIZE; i++)
+	// Instances are drawn in order, so the centre dots after all the marbles land on top of them
+	size_t marbles = circles.size();
+	for (size_t m = 0; m < marbles; m++)
 	{
-		for (int j = 0; j < BOARD_SIZE; j++)
-		{
-			bool isValid = true;
+		Instance dot = circles[m];
+		dot.scale = MARBLE_RADIUS * 0.1f;
+		dot.color = Vector3f(1.0f, 1.0f, 1.0f); // White center
+		circles.push_back(dot);
+	}
 
-			if ((i < 2 || i > 4) && (j < 2 || j > 4))
-			{
-				isValid = false;
-			}
+	uploadInstances(circleInstanceVBO, circles, GL_DYNAMIC_DRAW);
+	circleInstanceCount = circles.size();
+	drawnBoard = game.board;
+}
 
-			if (isValid)
-			{
-				board[i][j] = MARBLE;
-				remainingMarbles++;
-			}
-		}
+// The selection and the hint, rebuilt from those alone rather than from every cell
+static void updateHighlightInstances()
+{
+	Instance highlights[MAX_HIGHLIGHTS];
+	int count = 0;
+
+	if (selectedPosition.row >= 0)
+		highlights[count++] = makeInstance(selectedPosition.row, selectedPosition.col, SQUARE_SIZE, 1.0f, 1.0f, 0.0f);
+
+	if (hintVisible)
+	{
+		bool fromSelected = selectedPosition.row == hintMove.from.row && selectedPosition.col == hintMove.from.col;
+		bool toSelected = selectedPosition.row == hintMove.to.row && selectedPosition.col == hintMove.to.col;
+
+		if (!fromSelected) // Hint: marble to move
+			highlights[count++] = makeInstance(hintMove.from.row, hintMove.from.col, SQUARE_SIZE, 0.2f, 0.8f, 1.0f);
+		if (!toSelected) // Hint: where it lands
+			highlights[count++] = makeInstance(hintMove.to.row, hintMove.to.col, SQUARE_SIZE, 0.2f, 1.0f, 0.4f);
 	}
 
-	// Center position is empty
-	board[BOARD_SIZE / 2][BOARD_SIZE / 2] = EMPTY;
-	remainingMarbles--;
+	if (count == highlightInstanceCount && memcmp(highlights, drawnHighlights, count * sizeof(Instance)) == 0)
+		return;
+
+	memcpy(drawnHighlights, highlights, count * sizeof(Instance));
+	highlightInstanceCount = count;
 
-	moveHistory.clear();
-	currentMoveIndex = -1;
-	gameTime = 0.0f;
-	gameStatus = PLAYING;
+	glBindBuffer(GL_ARRAY_BUFFER, highlightInstanceVBO);
+	glBufferData(GL_ARRAY_BUFFER, count * sizeof(Instance), highlights, GL_DYNAMIC_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
 }
 
 static void createSquareBuffer()
@@ -169,6 +342,9 @@ static void createSquareBuffer()
 	glBindVertexArray(0);
 	glBindBuffer(GL_ARRAY_BUFFER, 0);
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+	createInstanceBuffer(squareVAO, squareInstanceVBO);
+	uploadCellInstances();
 	cout << "Square buffer created\n";
 }
 
@@ -211,6 +387,8 @@ static void createCircleBuffer()
 	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vector3f), (void *)0);
 
 	glBindVertexArray(0);
+
+	createInstanceBuffer(circleVAO, circleInstanceVBO);
 }
 
 static void createHighlightBuffer()
@@ -242,6 +420,8 @@ static void createHighlightBuffer()
 	glBindVertexArray(0);
 	glBindBuffer(GL_ARRAY_BUFFER, 0);
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+	createInstanceBuffer(highlightVAO, highlightInstanceVBO);
 	cout << "Highlight buffer created\n";
 }
 
@@ -322,184 +502,54 @@ static void CompileShaders()
 
 	glUseProgram(ShaderProgram);
 
-	gmodelLocation = glGetUniformLocation(ShaderProgram, "model"); 
 	gProjectionLocation = glGetUniformLocation(ShaderProgram, "projection");
-	gColorLocation = glGetUniformLocation(ShaderProgram, "color");
 
-	if (gmodelLocation == static_cast<GLuint>(-1))
-		fprintf(stderr, "Warning: Couldn't find uniform 'model'\n");
 	if (gProjectionLocation == static_cast<GLuint>(-1))
 		fprintf(stderr, "Warning: Couldn't find uniform 'projection'\n");
-	if (gColorLocation == static_cast<GLuint>(-1))
-		fprintf(stderr, "Warning: Couldn't find uniform 'color'\n");
 }
 
 /***************game logic functions******************/
 
-Position screenToBoard(double xpos, double ypos)
-{
-	float x = (2.0f * xpos) / theWindowWidth - 1.0f;
-	float y = 1.0f - (2.0f * ypos) / theWindowHeight;
-
-	float aspectRatio = (float)theWindowWidth / (float)theWindowHeight;
-	float orthoSize = 1.0f;
-	x *= orthoSize * aspectRatio;
-	y *= orthoSize;
-
-	float spacing = SQUARE_SIZE * 2.2f;
-	int col = static_cast<int>(round((x / spacing) + BOARD_SIZE / 2));
-	int row = static_cast<int>(round((BOARD_SIZE / 2) - (y / spacing)));
-
-	if (row >= 0 && row < BOARD_SIZE && col >= 0 && col < BOARD_SIZE)
-	{
-		if (!((row < 2 || row > 4) && (col < 2 || col > 4)))
-		{
-			return {row, col};
-		}
-	}
-
-	return {-1, -1}; 
-}
-
-bool isValidMove(Position from, Position to)
+// Make a move, flagging the error popup if it is illegal
+void makeMove(Position from, Position to)
 {
-    if (board[from.row][from.col] != MARBLE) {
-        lastMoveError = NO_MARBLE_SELECTED;
-        return false;
-    }
-
-    if (board[to.row][to.col] != EMPTY) {
-        lastMoveError = DESTINATION_NOT_EMPTY;
-        return false;
+	lastMoveError = game.makeMove(from, to);
+	if (lastMoveError != NONE) {
+        showMoveError = true;
+        moveErrorTime = glfwGetTime(); 
+        return;
     }
 
-    int rowDiff = abs(to.row - from.row);
-    int colDiff = abs(to.col - from.col);
-
-    if ((rowDiff == 2 && colDiff == 0) || (rowDiff == 0 && colDiff == 2)) {
-        int middleRow = (from.row + to.row) / 2;
-        int middleCol = (from.col + to.col) / 2;
-
-        if (board[middleRow][middleCol] == MARBLE) {
-            lastMoveError = NONE;
-            return true;
-        } else {
-            lastMoveError = NO_MARBLE_TO_JUMP;
-            return false;
-        }
-    }
-    
-    lastMoveError = INVALID_DISTANCE;
-    return false;
+	clearHint();
+	refreshSolvability();
 }
 
-bool hasAvailableMoves()
+void undoMove()
 {
-	for (int i = 0; i < BOARD_SIZE; i++)
+	if (game.undoMove())
 	{
-		for (int j = 0; j < BOARD_SIZE; j++)
-		{
-			if (board[i][j] == MARBLE)
-			{
-				Position directions[4] = {{-2, 0}, {2, 0}, {0, -2}, {0, 2}};
-
-				for (auto &dir : directions)
-				{
-					int newRow = i + dir.row;
-					int newCol = j + dir.col;
-
-					if (newRow >= 0 && newRow < BOARD_SIZE &&
-						newCol >= 0 && newCol < BOARD_SIZE)
-					{
-						if (isValidMove({i, j}, {newRow, newCol}))
-						{
-							return true;
-						}
-					}
-				}
-			}
-		}
+		clearHint();
+		refreshSolvability();
 	}
-
-	return false;
 }
 
-void checkGameStatus()
+void redoMove()
 {
-	if (remainingMarbles == 1)
-	{
-		gameStatus = WON;
-		return;
-	}
-
-	if (!hasAvailableMoves() && remainingMarbles > 1)
+	if (game.redoMove())
 	{
-		gameStatus = LOST;
+		clearHint();
+		refreshSolvability();
 	}
 }
 
-// Make a move
-void makeMove(Position from, Position to)
+// Jump to any point in the history in one step (timeline slider, Home/End)
+void goToMove(int ply)
 {
-	if (!isValidMove(from, to)) {
-        showMoveError = true;
-        moveErrorTime = glfwGetTime(); 
-        return;
-    }
-
-	int middleRow = (from.row + to.row) / 2;
-	int middleCol = (from.col + to.col) / 2;
-
-	board[from.row][from.col] = EMPTY;
-	board[to.row][to.col] = MARBLE;
-	board[middleRow][middleCol] = EMPTY;
-
-	remainingMarbles--;
-
-	Move move = {from, to, {middleRow, middleCol}};
-
-	if (currentMoveIndex < static_cast<int>(moveHistory.size()) - 1)
+	if (ply != game.currentPly() && game.goToMove(ply))
 	{
-		moveHistory.resize(currentMoveIndex + 1);
+		clearHint();
+		refreshSolvability();
 	}
-
-	moveHistory.push_back(move);
-	currentMoveIndex = moveHistory.size() - 1;
-
-	checkGameStatus();
-}
-
-void undoMove()
-{
-	if (currentMoveIndex < 0)
-		return;
-
-	Move &move = moveHistory[currentMoveIndex];
-
-	board[move.from.row][move.from.col] = MARBLE;
-	board[move.to.row][move.to.col] = EMPTY;
-	board[move.captured.row][move.captured.col] = MARBLE;
-
-	remainingMarbles++;
-	currentMoveIndex--;
-	gameStatus = PLAYING; 
-}
-
-void redoMove()
-{
-	if (currentMoveIndex >= static_cast<int>(moveHistory.size()) - 1)
-		return; 
-
-	currentMoveIndex++;
-	Move &move = moveHistory[currentMoveIndex];
-
-	board[move.from.row][move.from.col] = EMPTY;
-	board[move.to.row][move.to.col] = MARBLE;
-	board[move.captured.row][move.captured.col] = EMPTY;
-
-	remainingMarbles--;
-
-	checkGameStatus();
 }
 
 /********************************************************************
@@ -516,6 +566,30 @@ void onInit(int argc, char *argv[])
 
 	CompileShaders();
 
+	if (solvabilityDb.open(pSolvabilityDbFileName))
+	{
+		cout << "Solvability database loaded (" << solvabilityDb.size() << " positions)\n";
+		hintWorker.setDatabase(&solvabilityDb);
+	}
+
+	if (endgameTablebase.open(pEndgameTablebaseFileName))
+	{
+		cout << "Endgame tablebase loaded (up to " << endgameTablebase.maxMarbles() << " marbles)\n";
+		analysisWorker.setTablebase(&endgameTablebase);
+		hintWorker.setTablebase(&endgameTablebase);
+	}
+
+	if (openingBook.open(pOpeningBookFileName))
+	{
+		cout << "Opening book loaded (" << openingBook.size() << " positions, " << openingBook.plies() << " plies)\n";
+		analysisWorker.setOpeningBook(&openingBook);
+		hintWorker.setOpeningBook(&openingBook);
+	}
+	else
+	{
+		cout << "No opening book: hints and analysis in the opening will search (restore it with 'make book')\n";
+	}
+
 	// glEnable(GL_DEPTH_TEST);
 	glEnable(GL_BLEND);
 	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
@@ -534,99 +608,29 @@ static void renderBoard()
 
 	glUniformMatrix4fv(gProjectionLocation, 1, GL_FALSE, &projection.m[0][0]);
 
-	glUniform3f(gColorLocation, 1.0f, 0.3f, 0.3f);
-
-	Matrix4f backgroundModel;
-	backgroundModel.InitIdentity();
-	backgroundModel.m[0][0] = 0.8f;
-	backgroundModel.m[1][1] = 0.8f;
-	backgroundModel.m[2][2] = 1.1f;
-
-	glUniformMatrix4fv(gmodelLocation, 1, GL_FALSE, &backgroundModel.m[0][0]);
-
-	for (int i = 0; i < BOARD_SIZE; i++)
-	{
-		for (int j = 0; j < BOARD_SIZE; j++)
-		{
-			if ((i < 2 || i > 4) && (j < 2 || j > 4))
-				continue;
-
-			float x = (j - BOARD_SIZE / 2) * SQUARE_SIZE * 2.2f;
-			float y = (BOARD_SIZE / 2 - i) * SQUARE_SIZE * 2.2f;
-
-			if (selectedPosition.row == i && selectedPosition.col == j)
-			{
-				glBindVertexArray(highlightVAO);
-				glUniform3f(gColorLocation, 1.0f, 1.0f, 0.0f);
-
-				Matrix4f highlightModel;
-				highlightModel.InitIdentity();
-				highlightModel.m[3][0] = x;
-				highlightModel.m[3][1] = y;
-				highlightModel.m[0][0] = SQUARE_SIZE;
-				highlightModel.m[1][1] = SQUARE_SIZE;
-
-				glUniformMatrix4fv(gmodelLocation, 1, GL_FALSE, &highlightModel.m[0][0]);
-				glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
-				glBindVertexArray(0);
-			}
-
-			glBindVertexArray(squareVAO);
-			glUniform3f(gColorLocation, 0.5f, 0.5f, 0.5f);
-
-			Matrix4f squareModel;
-			squareModel.InitIdentity();
-			squareModel.m[3][0] = x;
-			squareModel.m[3][1] = y;
-			squareModel.m[0][0] = SQUARE_SIZE;
-			squareModel.m[1][1] = SQUARE_SIZE;
+	updateHighlightInstances();
+	updateMarbleInstances();
 
-			glUniformMatrix4fv(gmodelLocation, 1, GL_FALSE, &squareModel.m[0][0]);
-			glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
-			glBindVertexArray(0);
-
-			if (board[i][j] == MARBLE)
-			{
-				// cout << "Drawing marble at position (" << i << "," << j << ")" << endl;
-				glBindVertexArray(circleVAO);
-				glUniform3f(gColorLocation, 0.8f, 0.2f, 0.2f);
-
-				Matrix4f marbleModel;
-				marbleModel.InitIdentity();
-				marbleModel.m[3][0] = x;
-				marbleModel.m[3][1] = y;
-				marbleModel.m[0][0] = MARBLE_RADIUS;
-				marbleModel.m[1][1] = MARBLE_RADIUS;
-
-				glUniformMatrix4fv(gmodelLocation, 1, GL_FALSE, &marbleModel.m[0][0]);
-				glDrawElements(GL_TRIANGLES, CIRCLE_SEGMENTS * 3, GL_UNSIGNED_INT, 0);
-				glUniform3f(gColorLocation, 1.0f, 1.0f, 1.0f); // White center
-				Matrix4f dotModel = marbleModel;
-				dotModel.m[0][0] = MARBLE_RADIUS * 0.1f;
-				dotModel.m[1][1] = MARBLE_RADIUS * 0.1f;
-				glUniformMatrix4fv(gmodelLocation, 1, GL_FALSE, &dotModel.m[0][0]);
-				glDrawArrays(GL_TRIANGLE_FAN, 0, CIRCLE_SEGMENTS + 2);
-
-				glBindVertexArray(0);
-			}
-		}
-	}
+	// Highlights first: the cell squares cover all but their rim
+	drawInstances(highlightVAO, 6, highlightInstanceCount);
+	drawInstances(squareVAO, 6, squareInstanceCount);
+	drawInstances(circleVAO, CIRCLE_SEGMENTS * 3, circleInstanceCount);
 }
 
 void mouse_button_callback(GLFWwindow *window, int button, int action, int mods)
 {
-	if (gameStatus != PLAYING)
+	if (game.status != PLAYING)
 		return; 
 
 	double xpos, ypos;
 	glfwGetCursorPos(window, &xpos, &ypos);
-	Position boardPos = screenToBoard(xpos, ypos);
+	Position boardPos = screenToBoard(xpos, ypos, theWindowWidth, theWindowHeight);
 
 	if (button == GLFW_MOUSE_BUTTON_LEFT)
 	{
 		if (action == GLFW_PRESS)
 		{
-			if (boardPos.row >= 0 && board[boardPos.row][boardPos.col] == MARBLE)
+			if (boardPos.row >= 0 && hasMarble(game.board, boardPos.row, boardPos.col))
 			{
 				selectedPosition = boardPos;
 				isDragging = true;
@@ -650,8 +654,8 @@ void mouse_callback(GLFWwindow *window, double xpos, double ypos)
 {
 	if (isDragging)
 	{
-		Position boardPos = screenToBoard(xpos, ypos);
-		if (boardPos.row >= 0 && board[boardPos.row][boardPos.col] == EMPTY)
+		Position boardPos = screenToBoard(xpos, ypos, theWindowWidth, theWindowHeight);
+		if (boardPos.row >= 0 && !hasMarble(game.board, boardPos.row, boardPos.col))
 		{
 			// Potentially highlight valid drop targets
 		}
@@ -669,19 +673,31 @@ void key_callback(GLFWwindow *window, int key, int scancode, int action, int mod
 			break;
 
 		case GLFW_KEY_Z:
-			if (mods & GLFW_MOD_CONTROL && currentMoveIndex >= 0)
+			if (mods & GLFW_MOD_CONTROL && game.canUndo())
 			{
 				undoMove();
 			}
 			break;
 
 		case GLFW_KEY_Y:
-			if (mods & GLFW_MOD_CONTROL && currentMoveIndex < static_cast<int>(moveHistory.size()) - 1)
+			if (mods & GLFW_MOD_CONTROL && game.canRedo())
 			{
 				redoMove();
 			}
 			break;
 
+		case GLFW_KEY_H:
+			requestHint();
+			break;
+
+		case GLFW_KEY_HOME:
+			goToMove(0);
+			break;
+
+		case GLFW_KEY_END:
+			goToMove(game.historyLength);
+			break;
+
 		case GLFW_KEY_ESCAPE:
 			glfwSetWindowShouldClose(window, true);
 			break;
@@ -708,17 +724,35 @@ void RenderImGui()
 
 	// Create a game status window
 	ImGui::SetNextWindowPos(ImVec2(10, 10));
-	ImGui::SetNextWindowSize(ImVec2(200, 100));
+	ImGui::SetNextWindowSize(ImVec2(200, 120));
 	ImGui::Begin("Game Status", nullptr, ImGuiWindowFlags_NoResize | ImGuiWindowFlags_NoMove);
 
 	ImGui::Text("Time: %.1f seconds", gameTime);
-	ImGui::Text("Marbles Remaining: %d", remainingMarbles);
+	ImGui::Text("Marbles Remaining: %d", game.remainingMarbles);
+
+	pollSolvability();
+	if (solvabilityPending)
+	{
+		ImGui::TextColored(ImVec4(0.7f, 0.7f, 0.7f, 1), "Solvable: checking...");
+	}
+	else if (solvability == WINNABLE)
+	{
+		ImGui::TextColored(ImVec4(0, 1, 0, 1), "Solvable: yes");
+	}
+	else if (solvability == NOT_WINNABLE)
+	{
+		ImGui::TextColored(ImVec4(1, 0, 0, 1), "Solvable: no");
+	}
+	else
+	{
+		ImGui::TextColored(ImVec4(0.7f, 0.7f, 0.7f, 1), "Solvable: unknown");
+	}
 
-	if (gameStatus == WON)
+	if (game.status == WON)
 	{
 		ImGui::TextColored(ImVec4(0, 1, 0, 1), "You Won!");
 	}
-	else if (gameStatus == LOST)
+	else if (game.status == LOST)
 	{
 		ImGui::TextColored(ImVec4(1, 0, 0, 1), "Game Over!");
 	}
@@ -727,8 +761,7 @@ void RenderImGui()
 
 	// Create a control panel window
 	ImGui::SetNextWindowPos(ImVec2(theWindowWidth - 230, 10));
-	ImGui::SetNextWindowSize(ImVec2(200, 130));
-	ImGui::Begin("Controls", nullptr, ImGuiWindowFlags_NoResize | ImGuiWindowFlags_NoMove);
+	ImGui::Begin("Controls", nullptr, ImGuiWindowFlags_AlwaysAutoResize | ImGuiWindowFlags_NoMove);
 
 	if (ImGui::Button("Reset Game", ImVec2(180, 30)))
 	{
@@ -737,7 +770,7 @@ void RenderImGui()
 
 	if (ImGui::Button("Undo", ImVec2(85, 30)))
 	{
-		if (currentMoveIndex >= 0)
+		if (game.canUndo())
 		{
 			undoMove();
 		}
@@ -747,12 +780,67 @@ void RenderImGui()
 
 	if (ImGui::Button("Redo", ImVec2(85, 30)))
 	{
-		if (currentMoveIndex < static_cast<int>(moveHistory.size()) - 1)
+		if (game.canRedo())
 		{
 			redoMove();
 		}
 	}
 
+	if (ImGui::Button("|<", ImVec2(85, 20)))
+	{
+		goToMove(0);
+	}
+
+	ImGui::SameLine();
+
+	if (ImGui::Button(">|", ImVec2(85, 20)))
+	{
+		goToMove(game.historyLength);
+	}
+
+	// Timeline over the whole history, including undone moves still available to redo
+	int ply = game.currentPly();
+	ImGui::PushItemWidth(180);
+	if (ImGui::SliderInt("##timeline", &ply, 0, game.historyLength, "Move %d"))
+	{
+		goToMove(ply);
+	}
+	ImGui::PopItemWidth();
+
+	// Every move already explored from here; picking one makes it the line redo and the slider follow
+	int variations = game.variationCount();
+	if (variations > 1)
+	{
+		ImGui::Text("Variations:");
+
+		int active = game.activeVariation();
+		for (int i = 0; i < variations; i++)
+		{
+			string label = formatMove(decodeMove(game.variation(i)));
+
+			ImGui::PushID(i);
+			if (ImGui::RadioButton(label.c_str(), active == i))
+			{
+				game.selectVariation(i);
+			}
+			ImGui::PopID();
+		}
+	}
+
+	if (ImGui::Button("Hint (H)", ImVec2(180, 30)))
+	{
+		requestHint();
+	}
+
+	if (hintPending)
+	{
+		ImGui::TextColored(ImVec4(0.7f, 0.7f, 0.7f, 1), "Searching...");
+	}
+	else if (hintUnavailable)
+	{
+		ImGui::TextColored(ImVec4(1, 0.5f, 0.3f, 1), "No winning move found");
+	}
+
 	ImGui::End();
 
 	if (showMoveError) {
@@ -781,6 +869,9 @@ void RenderImGui()
                 case NO_MARBLE_TO_JUMP:
                     ImGui::Text("You must jump over another marble!");
                     break;
+                case DESTINATION_OFF_BOARD:
+                    ImGui::Text("Marbles must land on the board!");
+                    break;
                 default:
                     ImGui::Text("Invalid move!");
                     break;
@@ -804,7 +895,7 @@ int main(int argc, char *argv[])
 	}
 
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 2);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
 	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
 	glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
 	glfwWindowHint(GLFW_RESIZABLE, GL_FALSE);
@@ -840,11 +931,13 @@ int main(int argc, char *argv[])
 		double deltaTime = currentTime - lastFrameTime;
 		lastFrameTime = currentTime;
 
-		if (gameStatus == PLAYING)
+		if (game.status == PLAYING)
 		{
 			gameTime += deltaTime;
 		}
 
+		pollHint();
+
 		glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
@@ -858,10 +951,13 @@ int main(int argc, char *argv[])
 
 	glDeleteVertexArrays(1, &squareVAO);
 	glDeleteBuffers(1, &squareVBO);
+	glDeleteBuffers(1, &squareInstanceVBO);
 	glDeleteVertexArrays(1, &circleVAO);
 	glDeleteBuffers(1, &circleVBO);
+	glDeleteBuffers(1, &circleInstanceVBO);
 	glDeleteVertexArrays(1, &highlightVAO);
 	glDeleteBuffers(1, &highlightVBO);
+	glDeleteBuffers(1, &highlightInstanceVBO);
 
 	ImGui_ImplOpenGL3_Shutdown();
 	ImGui_ImplGlfw_Shutdown();
@@ -1,14 +1,16 @@
 #version 330 core
 layout(location = 0) in vec3 position;
 
-uniform mat4 model;
+// Per instance: where the shape sits, how large it is and its colour
+layout(location = 1) in vec2 offset;
+layout(location = 2) in float scale;
+layout(location = 3) in vec3 color;
+
 uniform mat4 projection;
-uniform vec3 color;
 
 out vec3 fragColor;
 
 void main() {
-    gl_Position = projection * model * vec4(position, 1.0);
+    gl_Position = projection * vec4(position.xy * scale + offset, position.z, 1.0);
     fragColor = color;
 }
-
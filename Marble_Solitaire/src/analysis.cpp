@@ -0,0 +1,193 @@
+#include <vector>
+
+#include "analysis.h"
+#include "position_class.h"
+
+AnalysisWorker::AnalysisWorker(double timeBudget)
+	: solver(20), database(NULL), book(NULL), cancelFlag(false), quit(false), pending(false), requested(0), generation(0), ready(false)
+{
+	solver.setCancelFlag(&cancelFlag);
+	solver.setTimeLimit(timeBudget);
+	thread = std::thread(&AnalysisWorker::run, this);
+}
+
+AnalysisWorker::~AnalysisWorker()
+{
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		quit = true;
+		cancelFlag = true;
+	}
+
+	wake.notify_one();
+	thread.join();
+}
+
+void AnalysisWorker::request(Bitboard board)
+{
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		generation++;
+		cancelFlag = true;
+
+		// A class no single marble belongs to: answered on the spot, without the thread
+		if (classFinishes(board) == 0)
+		{
+			latest.board = board;
+			latest.solvability = NOT_WINNABLE;
+			latest.hasMove = false;
+			pending = false;
+			ready = true;
+			return;
+		}
+
+		// The opening is settled ahead of time
+		bool winnable;
+		Move bestMove;
+		if (book && book->lookup(board, winnable, bestMove))
+		{
+			latest.board = board;
+			latest.solvability = winnable ? WINNABLE : NOT_WINNABLE;
+			latest.hasMove = winnable;
+			latest.bestMove = bestMove;
+			pending = false;
+			ready = true;
+			return;
+		}
+
+		requested = board;
+		pending = true;
+		ready = false;
+	}
+
+	wake.notify_one();
+}
+
+void AnalysisWorker::cancel()
+{
+	std::lock_guard<std::mutex> guard(lock);
+	pending = false;
+	ready = false;
+	generation++;
+	cancelFlag = true;
+}
+
+bool AnalysisWorker::poll(Analysis &result)
+{
+	std::lock_guard<std::mutex> guard(lock);
+
+	if (!ready)
+		return false;
+
+	result = latest;
+	return true;
+}
+
+void AnalysisWorker::setDatabase(const SolvabilityDatabase *database)
+{
+	std::lock_guard<std::mutex> guard(lock);
+	this->database = database;
+}
+
+void AnalysisWorker::setTablebase(const EndgameTablebase *tablebase)
+{
+	std::lock_guard<std::mutex> guard(lock);
+	solver.setTablebase(tablebase);
+}
+
+void AnalysisWorker::setOpeningBook(const OpeningBook *book)
+{
+	std::lock_guard<std::mutex> guard(lock);
+	this->book = book;
+}
+
+// Answer from the database: keep to moves whose result is still winnable
+bool AnalysisWorker::lookup(Bitboard board, Analysis &analysis) const
+{
+	if (!database || !database->isLoaded())
+		return false;
+
+	if (!database->isWinnable(board))
+	{
+		analysis.solvability = NOT_WINNABLE;
+		return true;
+	}
+
+	analysis.solvability = WINNABLE;
+
+	MoveMasks moves;
+	generateMoves(board, moves);
+
+	for (int dir = 0; dir < DIR_COUNT; dir++)
+	{
+		for (Bitboard origins = moves.from[dir]; origins; origins &= origins - 1)
+		{
+			int from = __builtin_ctzll(origins);
+
+			if (database->isWinnable(board ^ jumpMask(from, dir)))
+			{
+				analysis.hasMove = true;
+				analysis.bestMove = decodeMove(encodeJump(from, dir));
+				return true;
+			}
+		}
+	}
+
+	return true;
+}
+
+void AnalysisWorker::run()
+{
+	std::vector<Move> solution;
+
+	while (true)
+	{
+		Bitboard board;
+		unsigned job;
+
+		{
+			std::unique_lock<std::mutex> guard(lock);
+			while (!pending && !quit)
+				wake.wait(guard);
+
+			if (quit)
+				return;
+
+			board = requested;
+			job = generation;
+			pending = false;
+			cancelFlag = false;
+		}
+
+		Analysis analysis;
+		analysis.board = board;
+		analysis.hasMove = false;
+
+		if (lookup(board, analysis))
+		{
+			// Answered by the database
+		}
+		else if (solver.solve(board, solution))
+		{
+			analysis.solvability = WINNABLE;
+			if (!solution.empty())
+			{
+				analysis.hasMove = true;
+				analysis.bestMove = solution[0];
+			}
+		}
+		else
+		{
+			analysis.solvability = solver.aborted() ? SOLVABILITY_UNKNOWN : NOT_WINNABLE;
+		}
+
+		std::lock_guard<std::mutex> guard(lock);
+
+		// Superseded or cancelled while searching: nobody wants this answer
+		if (job != generation)
+			continue;
+
+		latest = analysis;
+		ready = true;
+	}
+}
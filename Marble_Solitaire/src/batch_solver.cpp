@@ -0,0 +1,122 @@
+#include <algorithm>
+
+#include "batch_solver.h"
+#include "position_class.h"
+#include "symmetry.h"
+
+// Number of slots examined before a lookup gives up or an insert overwrites
+const int PROBE_WINDOW = 4;
+
+BatchSolver::BatchSolver(int tableBits)
+	: table(1ULL << tableBits), mask((1ULL << tableBits) - 1), tablebase(NULL), tablebaseMarbles(0), nodeCount(0)
+{
+	clear();
+}
+
+Bitboard BatchSolver::finishes(Bitboard board)
+{
+	return search(board, pagodaValues(board));
+}
+
+void BatchSolver::solveSingleVacancies(Bitboard reachable[BOARD_SIZE * BOARD_STRIDE])
+{
+	for (int hole = 0; hole < BOARD_SIZE * BOARD_STRIDE; hole++)
+	{
+		// Starts in the same symmetry class as one already solved are a single table hit
+		reachable[hole] = (VALID_HOLES >> hole) & 1 ? finishes(VALID_HOLES & ~(1ULL << hole)) : 0;
+	}
+}
+
+void BatchSolver::setTablebase(const EndgameTablebase *tablebase)
+{
+	this->tablebase = tablebase;
+	tablebaseMarbles = tablebase && tablebase->isLoaded() ? tablebase->maxMarbles() : 0;
+}
+
+uint64_t BatchSolver::nodes() const
+{
+	return nodeCount;
+}
+
+void BatchSolver::clear()
+{
+	Entry empty = {0, 0};
+	std::fill(table.begin(), table.end(), empty);
+	nodeCount = 0;
+}
+
+const BatchSolver::Entry *BatchSolver::find(Bitboard canonical, uint64_t hash) const
+{
+	for (int i = 0; i < PROBE_WINDOW; i++)
+	{
+		const Entry &slot = table[(hash + i) & mask];
+
+		if (slot.board == canonical)
+			return &slot;
+		if (slot.board == 0)
+			return NULL;
+	}
+
+	return NULL;
+}
+
+void BatchSolver::insert(Bitboard canonical, uint64_t hash, Bitboard finishes)
+{
+	Entry entry = {canonical, finishes};
+
+	for (int i = 0; i < PROBE_WINDOW; i++)
+	{
+		Entry &slot = table[(hash + i) & mask];
+
+		if (slot.board == 0 || slot.board == canonical)
+		{
+			slot = entry;
+			return;
+		}
+	}
+
+	// Window full: replace a slot picked by the high hash bits
+	table[(hash + (hash >> 62)) & mask] = entry;
+}
+
+Bitboard BatchSolver::search(Bitboard board, PagodaValues pagoda)
+{
+	nodeCount++;
+
+	// A single marble left: it finishes where it stands
+	if ((board & (board - 1)) == 0)
+		return board;
+
+	// Everything this position could possibly finish on
+	Bitboard bound = classFinishes(board) & pagodaFinishes(pagoda);
+	if (bound == 0)
+		return 0;
+
+	if (countMarbles(board) <= tablebaseMarbles && !tablebase->isWinnable(board))
+		return 0;
+
+	int symmetry;
+	Bitboard canonical = canonicalBoard(board, symmetry);
+	uint64_t hash = canonicalHash(canonical);
+
+	const Entry *known = find(canonical, hash);
+	if (known)
+		return transformBoard(known->finishes, inverseSymmetry(symmetry));
+
+	MoveMasks moves;
+	generateMoves(board, moves);
+
+	Bitboard found = 0;
+
+	for (int dir = 0; dir < DIR_COUNT && found != bound; dir++)
+	{
+		for (Bitboard origins = moves.from[dir]; origins && found != bound; origins &= origins - 1)
+		{
+			int from = __builtin_ctzll(origins);
+			found |= search(board ^ jumpMask(from, dir), pagodaJump(pagoda, from, dir));
+		}
+	}
+
+	insert(canonical, hash, transformBoard(found, symmetry));
+	return found;
+}
@@ -0,0 +1,24 @@
+#include <math.h>
+
+#include "board_layout.h"
+
+Position screenToBoard(double xpos, double ypos, int windowWidth, int windowHeight)
+{
+	float x = (2.0f * xpos) / windowWidth - 1.0f;
+	float y = 1.0f - (2.0f * ypos) / windowHeight;
+
+	float aspectRatio = (float)windowWidth / (float)windowHeight;
+	float orthoSize = 1.0f;
+	x *= orthoSize * aspectRatio;
+	y *= orthoSize;
+
+	int col = static_cast<int>(round((x / CELL_SPACING) + BOARD_SIZE / 2));
+	int row = static_cast<int>(round((BOARD_SIZE / 2) - (y / CELL_SPACING)));
+
+	if (isBoardHole(row, col))
+	{
+		return {row, col};
+	}
+
+	return {-1, -1};
+}
@@ -0,0 +1,307 @@
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+#include "endgame_tablebase.h"
+
+const char TB_MAGIC[8] = {'M', 'S', 'E', 'N', 'D', 'G', 'T', 'B'};
+const uint32_t TB_VERSION = 1;
+const int HOLE_COUNT = 33;
+
+struct TbHeader
+{
+	char magic[8];
+	uint32_t version;
+	uint32_t maxMarbles;
+};
+
+// Binomial coefficients C(n, k) for n, k <= 33, the sizes and ranks of the layers
+struct Binomials
+{
+	uint64_t value[HOLE_COUNT + 1][HOLE_COUNT + 1];
+
+	Binomials()
+	{
+		for (int n = 0; n <= HOLE_COUNT; n++)
+		{
+			value[n][0] = 1;
+			for (int k = 1; k <= HOLE_COUNT; k++)
+				value[n][k] = n == 0 ? 0 : value[n - 1][k - 1] + value[n - 1][k];
+		}
+	}
+};
+
+static const Binomials binomials;
+
+// The 33 holes in reading order as bits 0-32: three holes in the arm rows, seven in the middle ones
+static uint64_t packHoles(Bitboard board)
+{
+	return ((board >> 2) & 0x7) | ((board >> 10) & 0x7) << 3 |
+		   ((board >> 16) & 0x7F) << 6 | ((board >> 24) & 0x7F) << 13 | ((board >> 32) & 0x7F) << 20 |
+		   ((board >> 42) & 0x7) << 27 | ((board >> 50) & 0x7) << 30;
+}
+
+static Bitboard unpackHoles(uint64_t holes)
+{
+	return (holes & 0x7) << 2 | ((holes >> 3) & 0x7) << 10 |
+		   ((holes >> 6) & 0x7F) << 16 | ((holes >> 13) & 0x7F) << 24 | ((holes >> 20) & 0x7F) << 32 |
+		   ((holes >> 27) & 0x7) << 42 | ((holes >> 30) & 0x7) << 50;
+}
+
+// Position of a packed set among all sets of the same size, in increasing numeric (colex) order
+static uint64_t rankHoles(uint64_t holes)
+{
+	uint64_t rank = 0;
+
+	for (int i = 1; holes; i++, holes &= holes - 1)
+		rank += binomials.value[__builtin_ctzll(holes)][i];
+
+	return rank;
+}
+
+static uint64_t layerWords(int marbles)
+{
+	return (binomials.value[HOLE_COUNT][marbles] + 63) / 64;
+}
+
+static bool testBit(const uint64_t *bits, uint64_t index)
+{
+	return (bits[index >> 6] >> (index & 63)) & 1;
+}
+
+EndgameTablebase::EndgameTablebase()
+	: mapping(NULL), mappingSize(0), marbleLimit(0)
+{
+	memset(layers, 0, sizeof(layers));
+}
+
+EndgameTablebase::~EndgameTablebase()
+{
+	close();
+}
+
+bool EndgameTablebase::open(const char *fileName)
+{
+	close();
+
+	int fd = ::open(fileName, O_RDONLY);
+	if (fd < 0)
+	{
+		fprintf(stderr, "Error in loading file: '%s'\n", fileName);
+		return false;
+	}
+
+	struct stat info;
+	if (fstat(fd, &info) != 0 || info.st_size < (off_t)sizeof(TbHeader))
+	{
+		fprintf(stderr, "Endgame tablebase '%s' is truncated\n", fileName);
+		::close(fd);
+		return false;
+	}
+
+	void *data = mmap(NULL, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	::close(fd);
+
+	if (data == MAP_FAILED)
+	{
+		fprintf(stderr, "Could not map endgame tablebase '%s'\n", fileName);
+		return false;
+	}
+
+	const TbHeader *header = static_cast<const TbHeader *>(data);
+	int limit = header->maxMarbles;
+	size_t expected = sizeof(TbHeader);
+
+	if (limit >= 1 && limit < HOLE_COUNT)
+	{
+		for (int marbles = 1; marbles <= limit; marbles++)
+			expected += layerWords(marbles) * sizeof(uint64_t);
+	}
+
+	if (memcmp(header->magic, TB_MAGIC, sizeof(TB_MAGIC)) != 0 || header->version != TB_VERSION ||
+		limit < 1 || limit >= HOLE_COUNT || (size_t)info.st_size != expected)
+	{
+		fprintf(stderr, "Endgame tablebase '%s' has the wrong format\n", fileName);
+		munmap(data, info.st_size);
+		return false;
+	}
+
+	mapping = data;
+	mappingSize = info.st_size;
+	marbleLimit = limit;
+
+	const uint64_t *layer = reinterpret_cast<const uint64_t *>(static_cast<const char *>(data) + sizeof(TbHeader));
+	for (int marbles = 1; marbles <= limit; marbles++)
+	{
+		layers[marbles] = layer;
+		layer += layerWords(marbles);
+	}
+
+	return true;
+}
+
+void EndgameTablebase::close()
+{
+	if (mapping)
+		munmap(mapping, mappingSize);
+
+	mapping = NULL;
+	mappingSize = 0;
+	marbleLimit = 0;
+	memset(layers, 0, sizeof(layers));
+}
+
+bool EndgameTablebase::isLoaded() const
+{
+	return mapping != NULL;
+}
+
+int EndgameTablebase::maxMarbles() const
+{
+	return marbleLimit;
+}
+
+bool EndgameTablebase::covers(Bitboard board) const
+{
+	int marbles = countMarbles(board);
+	return marbles >= 1 && marbles <= marbleLimit;
+}
+
+bool EndgameTablebase::isWinnable(Bitboard board) const
+{
+	if (!covers(board))
+		return false;
+
+	return testBit(layers[countMarbles(board)], rankHoles(packHoles(board)));
+}
+
+int EndgameTablebase::movesToWin(Bitboard board)
+{
+	return countMarbles(board) - 1;
+}
+
+int EndgameTablebase::winningLine(Bitboard board, MoveCode *line) const
+{
+	if (!isWinnable(board))
+		return -1;
+
+	int length = 0;
+
+	while (board & (board - 1))
+	{
+		// Every jump removes a marble, so a longer line means a corrupt or mismatched table
+		if (length >= MAX_GAME_MOVES)
+			return -1;
+
+		MoveMasks moves;
+		generateMoves(board, moves);
+
+		Bitboard next = board;
+		for (int dir = 0; dir < DIR_COUNT && next == board; dir++)
+		{
+			for (Bitboard origins = moves.from[dir]; origins; origins &= origins - 1)
+			{
+				int from = __builtin_ctzll(origins);
+
+				if (isWinnable(board ^ jumpMask(from, dir)))
+				{
+					next = board ^ jumpMask(from, dir);
+					line[length++] = encodeJump(from, dir);
+					break;
+				}
+			}
+		}
+
+		// A winnable position with no winnable successor: the table contradicts itself
+		if (next == board)
+			return -1;
+
+		board = next;
+	}
+
+	return length;
+}
+
+bool buildEndgameTablebase(const char *fileName, int maxMarbles, FILE *log)
+{
+	if (maxMarbles < 1 || maxMarbles >= HOLE_COUNT)
+	{
+		fprintf(stderr, "Cannot build a tablebase for %d marbles\n", maxMarbles);
+		return false;
+	}
+
+	std::vector<std::vector<uint64_t> > layers(maxMarbles + 1);
+
+	for (int marbles = 1; marbles <= maxMarbles; marbles++)
+	{
+		std::vector<uint64_t> &layer = layers[marbles];
+		layer.assign(layerWords(marbles), 0);
+
+		const uint64_t *smaller = marbles > 1 ? &layers[marbles - 1][0] : NULL;
+		uint64_t won = 0;
+		uint64_t index = 0;
+
+		// Every set of 'marbles' holes in increasing numeric order, which is exactly rank order
+		for (uint64_t holes = (1ULL << marbles) - 1; holes < (1ULL << HOLE_COUNT); index++)
+		{
+			bool win = marbles == 1;
+
+			if (!win)
+			{
+				Bitboard board = unpackHoles(holes);
+				MoveMasks moves;
+				generateMoves(board, moves);
+
+				for (int dir = 0; dir < DIR_COUNT && !win; dir++)
+				{
+					for (Bitboard origins = moves.from[dir]; origins && !win; origins &= origins - 1)
+					{
+						Bitboard next = board ^ jumpMask(__builtin_ctzll(origins), dir);
+						win = testBit(smaller, rankHoles(packHoles(next)));
+					}
+				}
+			}
+
+			if (win)
+			{
+				layer[index >> 6] |= 1ULL << (index & 63);
+				won++;
+			}
+
+			// Next set with the same number of holes (Gosper's hack)
+			uint64_t lowest = holes & -holes;
+			uint64_t ripple = holes + lowest;
+			holes = ripple | (((holes ^ ripple) >> 2) / lowest);
+		}
+
+		fprintf(log, "%2d marbles: %10llu positions, %10llu winnable\n", marbles, (unsigned long long)index,
+				(unsigned long long)won);
+	}
+
+	FILE *file = fopen(fileName, "wb");
+	if (!file)
+	{
+		fprintf(stderr, "Could not write '%s'\n", fileName);
+		return false;
+	}
+
+	TbHeader header;
+	memcpy(header.magic, TB_MAGIC, sizeof(TB_MAGIC));
+	header.version = TB_VERSION;
+	header.maxMarbles = maxMarbles;
+
+	bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+	for (int marbles = 1; marbles <= maxMarbles && ok; marbles++)
+		ok = fwrite(&layers[marbles][0], sizeof(uint64_t), layers[marbles].size(), file) == layers[marbles].size();
+
+	if (fclose(file) != 0 || !ok)
+	{
+		fprintf(stderr, "Could not write '%s'\n", fileName);
+		return false;
+	}
+
+	return true;
+}
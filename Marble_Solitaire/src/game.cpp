@@ -0,0 +1,255 @@
+#include "game.h"
+#include "position_class.h"
+#include "zobrist.h"
+
+const int NO_NODE = -1;
+
+// Explored moves the variation tree holds before it has to allocate (16 bytes each)
+const int VARIATION_POOL_SIZE = 4096;
+
+Game::Game()
+{
+	// reset() only reassigns the tree, so the pool survives every new game
+	tree.reserve(VARIATION_POOL_SIZE);
+	reset();
+}
+
+void Game::reset()
+{
+	VariationNode root = {NO_NODE, NO_NODE, NO_NODE, 0};
+	tree.assign(1, root);
+
+	loadPosition(START_POSITION);
+	positions[0] = START_POSITION;
+	lineNodes[0] = 0;
+	historyLength = 0;
+	currentMoveIndex = -1;
+}
+
+// Rebuild everything derived from the board; costs the same however far the jump
+void Game::loadPosition(Bitboard position)
+{
+	board = position;
+	hash = zobristHash(board);
+	remainingMarbles = countMarbles(board);
+	generateMoves(board, legalMoves);
+	legalMoveCount = countMoves(legalMoves);
+	pagoda = pagodaValues(board);
+	status = statusFromCounts();
+}
+
+MoveError Game::makeMove(Position from, Position to)
+{
+	MoveError error = validateMove(board, from, to);
+	if (error != NONE)
+		return error;
+
+	MoveCode code = encodeMove(makeJump(from, to));
+
+	// A jump toggles exactly the three holes it touches
+	Bitboard mask = jumpMask(code);
+	board ^= mask;
+	hash ^= zobristJump(jumpOrigin(code), jumpDirection(code));
+
+	// Twelve shifts and masks cover the whole board, cheaper than patching just the holes near the jump
+	generateMoves(board, legalMoves);
+	legalMoveCount = countMoves(legalMoves);
+	pagoda = pagodaJump(pagoda, jumpOrigin(code), jumpDirection(code));
+
+	remainingMarbles--;
+
+	// Replaying the next move of the line keeps it; anything else switches to that move's variation
+	int parent = lineNodes[currentMoveIndex + 1];
+	int child = findOrAddChild(parent, code);
+	tree[parent].chosenChild = child;
+
+	currentMoveIndex++;
+	if (currentMoveIndex >= historyLength || lineNodes[currentMoveIndex + 1] != child)
+	{
+		moveHistory[currentMoveIndex] = code;
+		positions[currentMoveIndex + 1] = board;
+		lineNodes[currentMoveIndex + 1] = child;
+		extendLine(currentMoveIndex + 1);
+	}
+
+	status = statusFromCounts();
+	return NONE;
+}
+
+// Position of 'move' among the children of 'node', adding it as the last child if it is new
+int Game::findOrAddChild(int node, MoveCode move)
+{
+	int *link = &tree[node].firstChild;
+
+	while (*link != NO_NODE)
+	{
+		if (tree[*link].move == move)
+			return *link;
+
+		link = &tree[*link].nextSibling;
+	}
+
+	VariationNode child = {NO_NODE, NO_NODE, NO_NODE, move};
+	int index = tree.size();
+	*link = index; // Before push_back, which may move the pool
+	tree.push_back(child);
+	return index;
+}
+
+int Game::childAt(int node, int index) const
+{
+	int child = tree[node].firstChild;
+
+	while (child != NO_NODE && index-- > 0)
+		child = tree[child].nextSibling;
+
+	return child;
+}
+
+// Rebuild the current line past 'ply' by following the chosen child at each node
+void Game::extendLine(int ply)
+{
+	int node = lineNodes[ply];
+
+	while (tree[node].chosenChild != NO_NODE)
+	{
+		node = tree[node].chosenChild;
+		moveHistory[ply] = tree[node].move;
+		positions[ply + 1] = positions[ply] ^ jumpMask(tree[node].move);
+		lineNodes[ply + 1] = node;
+		ply++;
+	}
+
+	historyLength = ply;
+}
+
+// Same answer as evaluateStatus(board), from the maintained counts instead of a rescan
+GameStatus Game::statusFromCounts() const
+{
+	if (remainingMarbles == 1)
+		return WON;
+
+	if (legalMoveCount == 0)
+		return LOST;
+
+	return PLAYING;
+}
+
+bool Game::isProvablyLost() const
+{
+	return status == LOST || (status == PLAYING && (pagodaFinishes(pagoda) & classFinishes(board)) == 0);
+}
+
+bool Game::canUndo() const
+{
+	return currentMoveIndex >= 0;
+}
+
+bool Game::canRedo() const
+{
+	return currentMoveIndex < historyLength - 1;
+}
+
+bool Game::undoMove()
+{
+	if (!canUndo())
+		return false;
+
+	MoveCode code = moveHistory[currentMoveIndex];
+	Bitboard mask = jumpMask(code);
+	board ^= mask;
+	hash ^= zobristJump(jumpOrigin(code), jumpDirection(code));
+	generateMoves(board, legalMoves);
+	legalMoveCount = countMoves(legalMoves);
+	pagoda = pagodaUndo(pagoda, jumpOrigin(code), jumpDirection(code));
+
+	remainingMarbles++;
+	currentMoveIndex--;
+	status = PLAYING;
+	return true;
+}
+
+int Game::currentPly() const
+{
+	return currentMoveIndex + 1;
+}
+
+bool Game::goToMove(int ply)
+{
+	if (ply < 0 || ply > historyLength)
+		return false;
+
+	loadPosition(positions[ply]);
+	currentMoveIndex = ply - 1;
+	return true;
+}
+
+bool Game::undoAll()
+{
+	return canUndo() && goToMove(0);
+}
+
+bool Game::redoAll()
+{
+	return canRedo() && goToMove(historyLength);
+}
+
+int Game::variationCount() const
+{
+	int count = 0;
+
+	for (int child = tree[lineNodes[currentPly()]].firstChild; child != NO_NODE; child = tree[child].nextSibling)
+		count++;
+
+	return count;
+}
+
+MoveCode Game::variation(int index) const
+{
+	return tree[childAt(lineNodes[currentPly()], index)].move;
+}
+
+int Game::activeVariation() const
+{
+	int node = lineNodes[currentPly()];
+	int index = 0;
+
+	for (int child = tree[node].firstChild; child != NO_NODE; child = tree[child].nextSibling, index++)
+	{
+		if (child == tree[node].chosenChild)
+			return index;
+	}
+
+	return -1;
+}
+
+bool Game::selectVariation(int index)
+{
+	int node = lineNodes[currentPly()];
+	int child = index >= 0 ? childAt(node, index) : NO_NODE;
+	if (child == NO_NODE)
+		return false;
+
+	tree[node].chosenChild = child;
+	extendLine(currentPly());
+	return true;
+}
+
+bool Game::redoMove()
+{
+	if (!canRedo())
+		return false;
+
+	currentMoveIndex++;
+	MoveCode code = moveHistory[currentMoveIndex];
+	Bitboard mask = jumpMask(code);
+	board ^= mask;
+	hash ^= zobristJump(jumpOrigin(code), jumpDirection(code));
+	generateMoves(board, legalMoves);
+	legalMoveCount = countMoves(legalMoves);
+	pagoda = pagodaJump(pagoda, jumpOrigin(code), jumpDirection(code));
+
+	remainingMarbles--;
+	status = statusFromCounts();
+	return true;
+}
@@ -0,0 +1,289 @@
+#include <algorithm>
+
+#include "minimum_move_solver.h"
+#include "position_class.h"
+#include "symmetry.h"
+
+// Number of slots examined before a lookup gives up or an insert overwrites
+const int PROBE_WINDOW = 4;
+
+// Total returned for positions that cannot finish on the target at all
+const int UNSOLVABLE = 1000;
+
+// The eight holes at the ends of the arms' outer rows; no jump passes over them
+const Bitboard CORNER_HOLES = cellBit(0, 2) | cellBit(0, 4) | cellBit(2, 0) | cellBit(4, 0) | cellBit(2, 6) |
+							  cellBit(4, 6) | cellBit(6, 2) | cellBit(6, 4);
+
+MinimumMoveSolver::MinimumMoveSolver(int tableBits)
+	: table(1ULL << tableBits), mask((1ULL << tableBits) - 1), target(0), finishes(VALID_HOLES), canonicalKeys(true),
+	  threshold(0), found(false), solutionMoves(0), tablebase(NULL), tablebaseMarbles(0), patterns(NULL), budget(0), nodeCount(0),
+	  stopped(false)
+{
+}
+
+int MinimumMoveSolver::solve(Bitboard board, std::vector<Move> &jumps, Bitboard target)
+{
+	Entry empty = {0, 0};
+	std::fill(table.begin(), table.end(), empty);
+
+	this->target = target;
+	finishes = (target ? target : VALID_HOLES) & classFinishes(board);
+	canonicalKeys = isSymmetric(target);
+	nodeCount = 0;
+	stopped = false;
+	found = false;
+	start = std::chrono::steady_clock::now();
+	jumps.clear();
+
+	if (finishes == 0)
+		return -1;
+
+	PagodaValues pagoda = pagodaValues(board);
+	threshold = estimate(board, -1);
+
+	if (threshold >= UNSOLVABLE)
+		return -1;
+
+	while (true)
+	{
+		reportProgress();
+
+		int next = search(board, -1, pagoda, 0, 0);
+
+		if (found)
+			break;
+		if (stopped || next >= UNSOLVABLE)
+			return -1;
+
+		threshold = next;
+	}
+
+	int length = countMarbles(board) - 1;
+	for (int i = 0; i < length; i++)
+		jumps.push_back(decodeMove(line[i]));
+
+	return solutionMoves;
+}
+
+void MinimumMoveSolver::setNodeBudget(uint64_t nodes)
+{
+	budget = nodes;
+}
+
+void MinimumMoveSolver::setProgressCallback(const MinimumMoveCallback &callback)
+{
+	this->callback = callback;
+}
+
+void MinimumMoveSolver::setTablebase(const EndgameTablebase *tablebase)
+{
+	this->tablebase = tablebase;
+	tablebaseMarbles = tablebase && tablebase->isLoaded() ? tablebase->maxMarbles() : 0;
+}
+
+void MinimumMoveSolver::setPatternDatabase(const PatternDatabase *patterns)
+{
+	this->patterns = patterns && patterns->isLoaded() ? patterns : NULL;
+}
+
+bool MinimumMoveSolver::aborted() const
+{
+	return stopped;
+}
+
+int MinimumMoveSolver::bound() const
+{
+	return threshold;
+}
+
+uint64_t MinimumMoveSolver::nodes() const
+{
+	return nodeCount;
+}
+
+int MinimumMoveSolver::lowerBound(Bitboard board, int last, Bitboard target)
+{
+	if ((board & (board - 1)) == 0)
+		return 0;
+
+	int corners = countMarbles(board & CORNER_HOLES);
+
+	// The chain in progress may pass through a corner, and the last marble may stay on one
+	if (last >= 0 && ((CORNER_HOLES >> last) & 1))
+		corners--;
+	if (target == 0 || (target & CORNER_HOLES))
+		corners--;
+
+	// More than one marble left and no chain to continue: at least one more move
+	bool canContinue = false;
+	if (last >= 0)
+	{
+		MoveMasks moves;
+		generateMoves(board, moves);
+
+		for (int dir = 0; dir < DIR_COUNT; dir++)
+			canContinue = canContinue || ((moves.from[dir] >> last) & 1);
+	}
+
+	return std::max(corners, canContinue ? 0 : 1);
+}
+
+// The stronger of the two admissible bounds; UNSOLVABLE if no region can keep the last marble
+int MinimumMoveSolver::estimate(Bitboard board, int last) const
+{
+	int bound = lowerBound(board, last, target);
+
+	if (patterns)
+	{
+		int regions = patterns->lowerBound(board, last, target);
+		if (regions >= PATTERN_DEAD)
+			return UNSOLVABLE;
+
+		bound = std::max(bound, regions);
+	}
+
+	return bound;
+}
+
+void MinimumMoveSolver::reportProgress()
+{
+	if (!callback)
+		return;
+
+	MinimumMoveProgress progress;
+	progress.bound = threshold;
+	progress.nodes = nodeCount;
+	progress.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	callback(progress);
+}
+
+uint64_t MinimumMoveSolver::stateKey(Bitboard board, int last) const
+{
+	if (canonicalKeys)
+	{
+		int symmetry;
+		board = canonicalBoard(board, symmetry);
+		if (last >= 0)
+			last = __builtin_ctzll(transformBoard(1ULL << last, symmetry));
+	}
+
+	// Boards only use bits 0-54, so the landing hole fits in the top byte
+	return board | static_cast<uint64_t>(last + 1) << 56;
+}
+
+int MinimumMoveSolver::storedBound(uint64_t key, uint64_t hash) const
+{
+	for (int i = 0; i < PROBE_WINDOW; i++)
+	{
+		const Entry &slot = table[(hash + i) & mask];
+
+		if (slot.key == key)
+			return slot.bound;
+		if (slot.key == 0)
+			return 0;
+	}
+
+	return 0;
+}
+
+void MinimumMoveSolver::storeBound(uint64_t key, uint64_t hash, int bound)
+{
+	Entry entry = {key, bound};
+
+	for (int i = 0; i < PROBE_WINDOW; i++)
+	{
+		Entry &slot = table[(hash + i) & mask];
+
+		if (slot.key == 0 || slot.key == key)
+		{
+			slot = entry;
+			return;
+		}
+	}
+
+	// Window full: replace a slot picked by the high hash bits
+	table[(hash + (hash >> 62)) & mask] = entry;
+}
+
+/*
+	Returns the smallest total ('made' plus moves still needed) found beyond
+	the threshold, or sets 'found' with the line in 'line'.
+*/
+int MinimumMoveSolver::search(Bitboard board, int last, PagodaValues pagoda, int made, int depth)
+{
+	if (++nodeCount % PROGRESS_INTERVAL == 0)
+		reportProgress();
+
+	if (budget && nodeCount >= budget)
+	{
+		stopped = true;
+		return UNSOLVABLE;
+	}
+
+	// A single marble left
+	if ((board & (board - 1)) == 0)
+	{
+		if (target != 0 && board != target)
+			return UNSOLVABLE;
+
+		found = true;
+		solutionMoves = made;
+		return made;
+	}
+
+	if ((pagodaFinishes(pagoda) & finishes) == 0)
+		return UNSOLVABLE;
+
+	if (countMarbles(board) <= tablebaseMarbles && !tablebase->isWinnable(board))
+		return UNSOLVABLE;
+
+	uint64_t key = stateKey(board, last);
+	uint64_t hash = canonicalHash(key);
+
+	int stored = storedBound(key, hash);
+	if (stored >= UNSOLVABLE)
+		return UNSOLVABLE;
+
+	int remaining = std::max(estimate(board, last), stored);
+	if (made + remaining > threshold)
+		return made + remaining;
+
+	MoveMasks moves;
+	generateMoves(board, moves);
+
+	// Continuing the chain costs nothing, so try those jumps first
+	Bitboard chain = last >= 0 ? 1ULL << last : 0;
+	int next = UNSOLVABLE;
+
+	for (int pass = 0; pass < 2; pass++)
+	{
+		for (int dir = 0; dir < DIR_COUNT; dir++)
+		{
+			Bitboard origins = pass == 0 ? moves.from[dir] & chain : moves.from[dir] & ~chain;
+
+			for (; origins; origins &= origins - 1)
+			{
+				int from = __builtin_ctzll(origins);
+				int landing = from + 2 * DIRECTION_STEP[dir];
+
+				int total = search(board ^ jumpMask(from, dir), landing, pagodaJump(pagoda, from, dir),
+								   made + pass, depth + 1);
+
+				if (found)
+				{
+					line[depth] = encodeJump(from, dir);
+					return total;
+				}
+
+				if (stopped)
+					return UNSOLVABLE;
+
+				next = std::min(next, total);
+			}
+		}
+	}
+
+	// Nothing within the threshold: every solution from here needs at least this many more moves
+	storeBound(key, hash, next >= UNSOLVABLE ? UNSOLVABLE : next - made);
+	return next;
+}
@@ -0,0 +1,80 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "notation.h"
+
+std::string formatBoard(Bitboard board)
+{
+	std::string text;
+
+	for (int row = 0; row < BOARD_SIZE; row++)
+	{
+		if (row > 0)
+			text += '/';
+
+		for (int col = 0; col < BOARD_SIZE; col++)
+		{
+			if (isBoardHole(row, col))
+				text += hasMarble(board, row, col) ? 'o' : '.';
+		}
+	}
+
+	return text;
+}
+
+bool parseBoard(const std::string &text, Bitboard &board)
+{
+	if (text.compare(0, 2, "0x") == 0)
+	{
+		char *end = NULL;
+		Bitboard value = strtoull(text.c_str(), &end, 16);
+
+		if (*end != '\0' || (value & ~VALID_HOLES) != 0)
+			return false;
+
+		board = value;
+		return true;
+	}
+
+	Bitboard value = 0;
+	int hole = 0;
+
+	for (size_t i = 0; i < text.size(); i++)
+	{
+		char c = text[i];
+
+		if (c == '/')
+			continue;
+		if (c != 'o' && c != '.')
+			return false;
+		if (hole >= 33)
+			return false;
+
+		// Find the board bit of the next hole in reading order
+		int index = 0;
+		for (int seen = -1; ; index++)
+		{
+			if (VALID_HOLES & (1ULL << index))
+				seen++;
+			if (seen == hole)
+				break;
+		}
+
+		if (c == 'o')
+			value |= 1ULL << index;
+		hole++;
+	}
+
+	if (hole != 33)
+		return false;
+
+	board = value;
+	return true;
+}
+
+std::string formatMove(const Move &move)
+{
+	char text[32];
+	snprintf(text, sizeof(text), "%d,%d-%d,%d", move.from.row, move.from.col, move.to.row, move.to.col);
+	return text;
+}
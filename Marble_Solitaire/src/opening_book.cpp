@@ -0,0 +1,269 @@
+#include <string.h>
+#include <algorithm>
+
+#include "opening_book.h"
+#include "solver.h"
+#include "symmetry.h"
+
+const char BOOK_MAGIC[8] = {'M', 'S', 'O', 'P', 'B', 'O', 'O', 'K'};
+const uint32_t BOOK_VERSION = 1;
+
+// Boards only use bits 0-54, so the top byte of an entry is free for the move
+const int BOOK_MOVE_SHIFT = 56;
+const uint64_t BOOK_BOARD_MASK = (1ULL << BOOK_MOVE_SHIFT) - 1;
+const MoveCode BOOK_LOST = 0xFF;
+
+struct BookHeader
+{
+	char magic[8];
+	uint32_t version;
+	uint32_t plies;
+	uint64_t entryCount;
+};
+
+static bool boardLess(uint64_t a, uint64_t b)
+{
+	return (a & BOOK_BOARD_MASK) < (b & BOOK_BOARD_MASK);
+}
+
+static uint64_t makeEntry(Bitboard canonical, MoveCode move)
+{
+	return canonical | (uint64_t)move << BOOK_MOVE_SHIFT;
+}
+
+// The entry for a canonical board in a sorted entry array, or NULL
+static const uint64_t *findEntry(const std::vector<uint64_t> &entries, Bitboard canonical)
+{
+	std::vector<uint64_t>::const_iterator it = std::lower_bound(entries.begin(), entries.end(), canonical, boardLess);
+
+	if (it == entries.end() || (*it & BOOK_BOARD_MASK) != canonical)
+		return NULL;
+
+	return &*it;
+}
+
+// The jump 'code' carried through 'symmetry': both ends move, and the direction follows them
+static MoveCode transformJump(MoveCode code, int symmetry)
+{
+	int from = jumpOrigin(code);
+	int to = from + 2 * DIRECTION_STEP[jumpDirection(code)];
+
+	int newFrom = __builtin_ctzll(transformBoard(1ULL << from, symmetry));
+	int newTo = __builtin_ctzll(transformBoard(1ULL << to, symmetry));
+
+	int dir = 0;
+	while (2 * DIRECTION_STEP[dir] != newTo - newFrom)
+		dir++;
+
+	return encodeJump(newFrom, dir);
+}
+
+OpeningBook::OpeningBook()
+	: depth(0)
+{
+}
+
+bool OpeningBook::open(const char *fileName)
+{
+	close();
+
+	FILE *file = fopen(fileName, "rb");
+	if (!file)
+	{
+		fprintf(stderr, "Error in loading file: '%s'\n", fileName);
+		return false;
+	}
+
+	// File size first, so a corrupt entry count is caught before it sizes an allocation
+	long fileSize = fseek(file, 0, SEEK_END) == 0 ? ftell(file) : -1;
+	rewind(file);
+
+	BookHeader header;
+	bool ok = fileSize >= (long)sizeof(header) && fread(&header, sizeof(header), 1, file) == 1 &&
+			  memcmp(header.magic, BOOK_MAGIC, sizeof(BOOK_MAGIC)) == 0 && header.version == BOOK_VERSION &&
+			  header.plies < (uint32_t)MAX_GAME_MOVES &&
+			  header.entryCount == (uint64_t)(fileSize - sizeof(header)) / sizeof(uint64_t) &&
+			  (uint64_t)(fileSize - sizeof(header)) % sizeof(uint64_t) == 0;
+
+	if (ok)
+	{
+		entries.resize(header.entryCount);
+		ok = fread(entries.data(), sizeof(uint64_t), entries.size(), file) == entries.size() && fgetc(file) == EOF;
+	}
+
+	// lookup() binary-searches the boards, so they must be strictly increasing
+	for (size_t i = 1; ok && i < entries.size(); i++)
+		ok = boardLess(entries[i - 1], entries[i]);
+
+	fclose(file);
+
+	if (!ok)
+	{
+		fprintf(stderr, "Opening book '%s' has the wrong format\n", fileName);
+		entries.clear();
+		return false;
+	}
+
+	depth = header.plies;
+	return true;
+}
+
+void OpeningBook::close()
+{
+	entries.clear();
+	depth = 0;
+}
+
+bool OpeningBook::isLoaded() const
+{
+	return !entries.empty();
+}
+
+int OpeningBook::plies() const
+{
+	return depth;
+}
+
+size_t OpeningBook::size() const
+{
+	return entries.size();
+}
+
+bool OpeningBook::lookup(Bitboard board, bool &winnable, Move &bestMove) const
+{
+	int symmetry;
+	Bitboard canonical = canonicalBoard(board, symmetry);
+
+	const uint64_t *entry = findEntry(entries, canonical);
+	if (!entry)
+		return false;
+
+	MoveCode move = *entry >> BOOK_MOVE_SHIFT;
+	winnable = move != BOOK_LOST;
+
+	// Stored for the canonical image: undo the symmetry that produced it
+	if (winnable)
+		bestMove = decodeMove(transformJump(move, inverseSymmetry(symmetry)));
+
+	return true;
+}
+
+// Canonical successors of every position in 'layer', sorted and without duplicates
+static void expandLayer(const std::vector<Bitboard> &layer, std::vector<Bitboard> &next)
+{
+	next.clear();
+
+	for (size_t i = 0; i < layer.size(); i++)
+	{
+		MoveMasks moves;
+		generateMoves(layer[i], moves);
+
+		for (int dir = 0; dir < DIR_COUNT; dir++)
+		{
+			for (Bitboard origins = moves.from[dir]; origins; origins &= origins - 1)
+				next.push_back(canonicalBoard(layer[i] ^ jumpMask(__builtin_ctzll(origins), dir)));
+		}
+	}
+
+	std::sort(next.begin(), next.end());
+	next.erase(std::unique(next.begin(), next.end()), next.end());
+}
+
+// A move from canonical 'board' to a winnable entry of the next ply, or BOOK_LOST
+static MoveCode bookMove(Bitboard board, const std::vector<uint64_t> &below)
+{
+	MoveMasks moves;
+	generateMoves(board, moves);
+
+	for (int dir = 0; dir < DIR_COUNT; dir++)
+	{
+		for (Bitboard origins = moves.from[dir]; origins; origins &= origins - 1)
+		{
+			int from = __builtin_ctzll(origins);
+			const uint64_t *child = findEntry(below, canonicalBoard(board ^ jumpMask(from, dir)));
+
+			if (child && (*child >> BOOK_MOVE_SHIFT) != BOOK_LOST)
+				return encodeJump(from, dir);
+		}
+	}
+
+	return BOOK_LOST;
+}
+
+bool buildOpeningBook(const char *fileName, int plies, const EndgameTablebase *tablebase, FILE *log)
+{
+	if (plies < 0 || plies >= MAX_GAME_MOVES)
+	{
+		fprintf(stderr, "Cannot build an opening book %d plies deep\n", plies);
+		return false;
+	}
+
+	// Ply 0: the standard start and every other single vacancy, one per symmetry class
+	std::vector<std::vector<Bitboard> > layers(plies + 1);
+	for (Bitboard holes = VALID_HOLES; holes; holes &= holes - 1)
+		layers[0].push_back(canonicalBoard(VALID_HOLES & ~(holes & -holes)));
+
+	std::sort(layers[0].begin(), layers[0].end());
+	layers[0].erase(std::unique(layers[0].begin(), layers[0].end()), layers[0].end());
+
+	for (int ply = 1; ply <= plies; ply++)
+		expandLayer(layers[ply - 1], layers[ply]);
+
+	// The deepest ply by search: one solver for the lot, so known-lost positions carry over
+	Solver solver;
+	solver.setTablebase(tablebase);
+
+	std::vector<std::vector<uint64_t> > results(plies + 1);
+	std::vector<Move> solution;
+
+	for (int ply = plies; ply >= 0; ply--)
+	{
+		const std::vector<Bitboard> &layer = layers[ply];
+		size_t won = 0;
+
+		for (size_t i = 0; i < layer.size(); i++)
+		{
+			MoveCode move;
+
+			if (ply == plies)
+				move = solver.solve(layer[i], solution) ? encodeMove(solution[0]) : BOOK_LOST;
+			else
+				move = bookMove(layer[i], results[ply + 1]);
+
+			results[ply].push_back(makeEntry(layer[i], move));
+			won += move != BOOK_LOST;
+		}
+
+		fprintf(log, "ply %2d: %7zu positions, %7zu winnable\n", ply, layer.size(), won);
+	}
+
+	// Positions of different plies have different marble counts, so no board appears twice
+	std::vector<uint64_t> entries;
+	for (int ply = 0; ply <= plies; ply++)
+		entries.insert(entries.end(), results[ply].begin(), results[ply].end());
+	std::sort(entries.begin(), entries.end(), boardLess);
+
+	FILE *file = fopen(fileName, "wb");
+	if (!file)
+	{
+		fprintf(stderr, "Could not write '%s'\n", fileName);
+		return false;
+	}
+
+	BookHeader header;
+	memcpy(header.magic, BOOK_MAGIC, sizeof(BOOK_MAGIC));
+	header.version = BOOK_VERSION;
+	header.plies = plies;
+	header.entryCount = entries.size();
+
+	bool ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+			  fwrite(entries.data(), sizeof(uint64_t), entries.size(), file) == entries.size();
+
+	if (fclose(file) != 0 || !ok)
+	{
+		fprintf(stderr, "Could not write '%s'\n", fileName);
+		return false;
+	}
+
+	return true;
+}
@@ -0,0 +1,212 @@
+#include <stdio.h>
+
+#include "pagoda.h"
+
+/*
+	Found by integer linear programming over positions the solvability
+	database marks as lost: each maximises w(h) minus the weighted sum of a
+	lost position, subject to the pagoda condition. These eight are the
+	greedy pick that rules out the most (position, final hole) pairs.
+*/
+const int8_t PAGODA_WEIGHTS[PAGODA_COUNT][BOARD_SIZE][BOARD_SIZE] = {
+	{
+		{ 0,  0,  0,  0,  0,  0,  0},
+		{ 0,  0,  0,  1,  0,  0,  0},
+		{-1,  1,  0,  1,  0,  1, -1},
+		{ 0,  0,  0,  0,  0,  0,  0},
+		{-1,  1,  0,  1,  0,  1, -1},
+		{ 0,  0,  0,  1,  0,  0,  0},
+		{ 0,  0,  0,  0,  0,  0,  0},
+	},
+	{
+		{ 0,  0, -1,  0, -1,  0,  0},
+		{ 0,  0,  1,  0,  1,  0,  0},
+		{ 0,  0,  0,  0,  0,  0,  0},
+		{ 0,  1,  1,  0,  1,  1,  0},
+		{ 0,  0,  0,  0,  0,  0,  0},
+		{ 0,  0,  1,  0,  1,  0,  0},
+		{ 0,  0, -1,  0, -1,  0,  0},
+	},
+	{
+		{ 0,  0,  0,  0,  0,  0,  0},
+		{ 0,  0,  0,  1,  0,  0,  0},
+		{-1,  1,  0,  1,  0,  1, -1},
+		{ 0,  0,  0,  0,  0,  0,  0},
+		{-1,  1,  0,  1,  0,  1, -1},
+		{ 0,  0,  0,  0,  0,  0,  0},
+		{ 0,  0,  0,  1,  0,  0,  0},
+	},
+	{
+		{ 0,  0, -1,  0, -1,  0,  0},
+		{ 0,  0,  1,  0,  1,  0,  0},
+		{ 0,  0,  0,  0,  0,  0,  0},
+		{ 0,  1,  1,  0,  1,  0,  1},
+		{ 0,  0,  0,  0,  0,  0,  0},
+		{ 0,  0,  1,  0,  1,  0,  0},
+		{ 0,  0, -1,  0, -1,  0,  0},
+	},
+	{
+		{ 0,  0,  0,  1,  0,  0,  0},
+		{ 0,  0,  0,  0,  0,  0,  0},
+		{-1,  1,  0,  1,  0,  1, -1},
+		{ 0,  0,  0,  0,  0,  0,  0},
+		{-1,  1,  0,  1,  0,  1, -1},
+		{ 0,  0,  0,  1,  0,  0,  0},
+		{ 0,  0,  0,  0,  0,  0,  0},
+	},
+	{
+		{ 0,  0, -1,  0, -1,  0,  0},
+		{ 0,  0,  1,  0,  1,  0,  0},
+		{ 0,  0,  0,  0,  0,  0,  0},
+		{ 1,  0,  1,  0,  1,  1,  0},
+		{ 0,  0,  0,  0,  0,  0,  0},
+		{ 0,  0,  1,  0,  1,  0,  0},
+		{ 0,  0, -1,  0, -1,  0,  0},
+	},
+	{
+		{ 0,  0,  0,  0,  0,  0,  0},
+		{ 0,  0,  0,  4,  0,  0,  0},
+		{-1,  1,  0,  1,  0,  1, -1},
+		{ 0,  3,  0,  3,  0,  3,  0},
+		{-1,  1,  0,  1,  0,  1, -1},
+		{ 0,  0,  0,  2,  0,  0,  0},
+		{ 0,  0,  0,  0,  0,  0,  0},
+	},
+	{
+		{ 0,  0,  0,  0,  0,  0,  0},
+		{ 0,  0,  0,  1,  0,  0,  0},
+		{-1,  1,  0,  1,  0,  1, -1},
+		{ 1,  2,  0,  2,  0,  2,  1},
+		{-2,  2,  0,  2,  0,  2, -2},
+		{ 0,  0,  0,  4,  0,  0,  0},
+		{ 0,  0,  0,  0,  0,  0,  0},
+	},
+};
+
+// Derived from the weights on first use, after checking them
+PagodaTables::PagodaTables()
+{
+	for (int bit = 0; bit < 64; bit++)
+	{
+		hole[bit] = 0;
+
+		int row = bit / BOARD_STRIDE;
+		int col = bit % BOARD_STRIDE;
+		if (!isBoardHole(row, col))
+			continue;
+
+		for (int k = 0; k < PAGODA_COUNT; k++)
+			hole[bit] += static_cast<uint64_t>(static_cast<uint8_t>(PAGODA_WEIGHTS[k][row][col])) << (8 * k);
+	}
+
+	for (int dir = 0; dir < DIR_COUNT; dir++)
+	{
+		int step = DIRECTION_STEP[dir];
+
+		for (int from = 0; from < 64; from++)
+		{
+			drop[dir][from] = 0;
+
+			int to = from + 2 * step;
+			if (to < 0 || to >= 64 || (jumpMask(from, dir) & ~VALID_HOLES) != 0)
+				continue;
+
+			for (int k = 0; k < PAGODA_COUNT; k++)
+			{
+				int lost = lane(hole[from], k) + lane(hole[from + step], k) - lane(hole[to], k);
+				drop[dir][from] |= static_cast<uint64_t>(lost) << (8 * k);
+			}
+		}
+	}
+
+	// Weights that break the pagoda condition would prune winnable positions: prune nothing instead
+	bool valid = verifyPagodaWeights();
+	if (!valid)
+		fprintf(stderr, "Warning: invalid pagoda weights, pruning disabled\n");
+
+	for (int k = 0; k < PAGODA_COUNT; k++)
+	{
+		for (int value = 0; value < 256; value++)
+		{
+			reachable[k][value] = valid ? 0 : VALID_HOLES;
+
+			for (int bit = 0; bit < 64; bit++)
+			{
+				if ((VALID_HOLES >> bit & 1) && lane(hole[bit], k) + PAGODA_BIAS <= value)
+					reachable[k][value] |= 1ULL << bit;
+			}
+		}
+	}
+}
+
+PagodaValues pagodaValues(Bitboard board)
+{
+	const PagodaTables &tables = pagodaTables();
+	PagodaValues values = 0;
+
+	for (int k = 0; k < PAGODA_COUNT; k++)
+	{
+		int sum = PAGODA_BIAS;
+
+		for (Bitboard marbles = board; marbles; marbles &= marbles - 1)
+			sum += PagodaTables::lane(tables.hole[__builtin_ctzll(marbles)], k);
+
+		values |= static_cast<uint64_t>(sum) << (8 * k);
+	}
+
+	return values;
+}
+
+Bitboard pagodaFinishes(PagodaValues values)
+{
+	const PagodaTables &tables = pagodaTables();
+	Bitboard holes = VALID_HOLES;
+
+	for (int k = 0; k < PAGODA_COUNT; k++)
+		holes &= tables.reachable[k][(values >> (8 * k)) & 0xFF];
+
+	return holes;
+}
+
+bool verifyPagodaWeights()
+{
+	for (int k = 0; k < PAGODA_COUNT; k++)
+	{
+		int positive = 0;
+		int negative = 0;
+
+		for (int row = 0; row < BOARD_SIZE; row++)
+		{
+			for (int col = 0; col < BOARD_SIZE; col++)
+			{
+				int weight = PAGODA_WEIGHTS[k][row][col];
+
+				if (!isBoardHole(row, col))
+				{
+					if (weight != 0)
+						return false;
+					continue;
+				}
+
+				(weight > 0 ? positive : negative) += weight;
+
+				for (int dir = 0; dir < DIR_COUNT; dir++)
+				{
+					int step = DIRECTION_STEP[dir];
+					int overRow = row + step / BOARD_STRIDE, overCol = col + step % BOARD_STRIDE;
+					int toRow = row + 2 * (step / BOARD_STRIDE), toCol = col + 2 * (step % BOARD_STRIDE);
+
+					if (isBoardHole(toRow, toCol) &&
+						PAGODA_WEIGHTS[k][toRow][toCol] > weight + PAGODA_WEIGHTS[k][overRow][overCol])
+						return false;
+				}
+			}
+		}
+
+		// Every lane must stay within its byte for any set of marbles
+		if (PAGODA_BIAS + negative < 0 || PAGODA_BIAS + positive > 255)
+			return false;
+	}
+
+	return true;
+}
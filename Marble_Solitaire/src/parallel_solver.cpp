@@ -0,0 +1,360 @@
+#include <algorithm>
+#include <thread>
+
+#include "parallel_solver.h"
+#include "position_class.h"
+#include "symmetry.h"
+
+// Number of slots examined before a lookup gives up or an insert overwrites
+const int PROBE_WINDOW = 4;
+
+// How many nodes a thread searches between checks of the stop flag
+const uint64_t STOP_CHECK_INTERVAL = 1024;
+
+AtomicTranspositionTable::AtomicTranspositionTable(int sizeBits)
+	: slots(new std::atomic<Bitboard>[1ULL << sizeBits]), mask((1ULL << sizeBits) - 1)
+{
+	clear();
+}
+
+bool AtomicTranspositionTable::contains(Bitboard board, uint64_t hash) const
+{
+	for (int i = 0; i < PROBE_WINDOW; i++)
+	{
+		Bitboard slot = slots[(hash + i) & mask].load(std::memory_order_relaxed);
+
+		if (slot == board)
+			return true;
+		if (slot == 0)
+			return false;
+	}
+
+	return false;
+}
+
+void AtomicTranspositionTable::insert(Bitboard board, uint64_t hash)
+{
+	for (int i = 0; i < PROBE_WINDOW; i++)
+	{
+		std::atomic<Bitboard> &slot = slots[(hash + i) & mask];
+		Bitboard current = slot.load(std::memory_order_relaxed);
+
+		if (current == board)
+			return;
+
+		if (current == 0 && slot.compare_exchange_strong(current, board, std::memory_order_relaxed))
+			return;
+
+		// Lost the race for an empty slot to the same position
+		if (current == board)
+			return;
+	}
+
+	// Window full: replace a slot picked by the high hash bits
+	slots[(hash + (hash >> 62)) & mask].store(board, std::memory_order_relaxed);
+}
+
+void AtomicTranspositionTable::clear()
+{
+	for (uint64_t i = 0; i <= mask; i++)
+		slots[i].store(0, std::memory_order_relaxed);
+}
+
+// Split depth for 'threads' threads: the number of tasks grows about fivefold per ply
+static int automaticSplitDepth(int threads)
+{
+	if (threads <= 4)
+		return 4;
+	return threads <= 16 ? 5 : 6;
+}
+
+ParallelSolver::ParallelSolver(int threads, int tableBits, int splitDepth)
+	: threadCount(threads < 1 ? 1 : threads), splitDepth(splitDepth > 0 ? splitDepth : automaticSplitDepth(threads)),
+	  table(tableBits), target(0), finishes(VALID_HOLES), canonicalKeys(true), tablebase(NULL), tablebaseMarbles(0), stop(false),
+	  cancelRequested(false), found(false), pending(0), queued(0), nodeCount(0), winningLength(0)
+{
+	for (int i = 0; i < threadCount; i++)
+		queues.push_back(std::unique_ptr<WorkQueue>(new WorkQueue()));
+}
+
+bool ParallelSolver::solve(Bitboard board, std::vector<Move> &solution, Bitboard target)
+{
+	// Known-lost positions are only lost with respect to one target
+	if (this->target != target)
+		table.clear();
+
+	this->target = target;
+	finishes = (target ? target : VALID_HOLES) & classFinishes(board);
+	canonicalKeys = isSymmetric(target);
+	stop = false;
+	found = false;
+	nodeCount = 0;
+	winningLength = 0;
+	solution.clear();
+
+	// Ruled out by the class invariant: no need to start a single thread
+	if (finishes == 0)
+		return false;
+
+	Task root;
+	root.board = board;
+	root.depth = 0;
+	queues[0]->tasks.push_back(root);
+	pending = 1;
+	queued = 1;
+
+	std::vector<std::thread> workers;
+	for (int i = 1; i < threadCount; i++)
+		workers.push_back(std::thread(&ParallelSolver::worker, this, i));
+
+	worker(0);
+
+	for (size_t i = 0; i < workers.size(); i++)
+		workers[i].join();
+
+	// A cancelled or successful run can leave tasks behind
+	for (int i = 0; i < threadCount; i++)
+		queues[i]->tasks.clear();
+	queued = 0;
+
+	if (!found)
+		return false;
+
+	for (int i = 0; i < winningLength; i++)
+		solution.push_back(decodeMove(winningPath[i]));
+
+	return true;
+}
+
+void ParallelSolver::cancel()
+{
+	cancelRequested = true;
+	wakeIdle();
+}
+
+void ParallelSolver::clearCancel()
+{
+	cancelRequested = false;
+}
+
+bool ParallelSolver::cancelled() const
+{
+	return cancelRequested;
+}
+
+// A win was found or the solve was cancelled
+bool ParallelSolver::halted() const
+{
+	return stop.load(std::memory_order_relaxed) || cancelRequested.load(std::memory_order_relaxed);
+}
+
+// Wake every sleeping thread to look again; the lock orders this after the state change it reports
+void ParallelSolver::wakeIdle()
+{
+	std::lock_guard<std::mutex> guard(idleLock);
+	idle.notify_all();
+}
+
+void ParallelSolver::setTablebase(const EndgameTablebase *tablebase)
+{
+	this->tablebase = tablebase;
+	tablebaseMarbles = tablebase && tablebase->isLoaded() ? tablebase->maxMarbles() : 0;
+}
+
+uint64_t ParallelSolver::nodes() const
+{
+	return nodeCount;
+}
+
+int ParallelSolver::threads() const
+{
+	return threadCount;
+}
+
+void ParallelSolver::worker(int id)
+{
+	uint64_t nodes = 0;
+	Task task;
+
+	while (!halted())
+	{
+		if (!takeTask(id, task))
+		{
+			// Sleep until a task is queued, the last one finishes or the search stops
+			std::unique_lock<std::mutex> guard(idleLock);
+			idle.wait(guard, [this] { return queued.load() > 0 || pending.load() == 0 || halted(); });
+
+			if (pending.load() == 0)
+				break;
+			continue;
+		}
+
+		if (task.depth < splitDepth)
+		{
+			expandTask(id, task, nodes);
+		}
+		else if (search(task.board, pagodaValues(task.board), task.depth, task.path, nodes))
+		{
+			reportWin(task.path, countMarbles(task.board) - 1 + task.depth);
+		}
+
+		// The last task done: every thread still waiting can leave
+		if (pending.fetch_sub(1) == 1)
+			wakeIdle();
+	}
+
+	nodeCount += nodes;
+}
+
+bool ParallelSolver::takeTask(int id, Task &task)
+{
+	{
+		WorkQueue &own = *queues[id];
+		std::lock_guard<std::mutex> guard(own.lock);
+
+		if (!own.tasks.empty())
+		{
+			task = own.tasks.back();
+			own.tasks.pop_back();
+			queued.fetch_sub(1);
+			return true;
+		}
+	}
+
+	for (int i = 1; i < threadCount; i++)
+	{
+		WorkQueue &victim = *queues[(id + i) % threadCount];
+		std::lock_guard<std::mutex> guard(victim.lock);
+
+		if (!victim.tasks.empty())
+		{
+			task = victim.tasks.front();
+			victim.tasks.pop_front();
+			queued.fetch_sub(1);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void ParallelSolver::expandTask(int id, const Task &task, uint64_t &nodes)
+{
+	Bitboard board = task.board;
+	nodes++;
+
+	if ((board & (board - 1)) == 0)
+	{
+		if (target == 0 || board == target)
+			reportWin(task.path, task.depth);
+		return;
+	}
+
+	MoveMasks moves;
+	generateMoves(board, moves);
+
+	Task child;
+	child.depth = task.depth + 1;
+	std::copy(task.path, task.path + task.depth, child.path);
+
+	MoveCode codes[DIR_COUNT * BOARD_SIZE * BOARD_SIZE];
+	int count = 0;
+
+	for (int dir = 0; dir < DIR_COUNT; dir++)
+	{
+		for (Bitboard origins = moves.from[dir]; origins; origins &= origins - 1)
+			codes[count++] = encodeJump(__builtin_ctzll(origins), dir);
+	}
+
+	// Count the children before the parent is retired so 'pending' never dips to zero early
+	pending.fetch_add(count);
+
+	{
+		WorkQueue &own = *queues[id];
+		std::lock_guard<std::mutex> guard(own.lock);
+
+		// Counted before they are visible, so a thief can never take one ahead of its count
+		queued.fetch_add(count);
+
+		// Pushed last-first, so the owner pops them in the same order Solver would search them
+		for (int i = count - 1; i >= 0; i--)
+		{
+			child.board = board ^ jumpMask(codes[i]);
+			child.path[task.depth] = codes[i];
+			own.tasks.push_back(child);
+		}
+	}
+
+	if (count > 0)
+		wakeIdle();
+}
+
+bool ParallelSolver::search(Bitboard board, PagodaValues pagoda, int depth, MoveCode *path, uint64_t &nodes)
+{
+	if (++nodes % STOP_CHECK_INTERVAL == 0 && halted())
+		return false;
+
+	// A single marble left
+	if ((board & (board - 1)) == 0)
+		return target == 0 || board == target;
+
+	if ((pagodaFinishes(pagoda) & finishes) == 0)
+		return false;
+
+	if (countMarbles(board) <= tablebaseMarbles)
+	{
+		if (!tablebase->isWinnable(board))
+			return false;
+
+		// No line from a table that contradicts itself: search on instead
+		if (target == 0 && tablebase->winningLine(board, path + depth) >= 0)
+			return true;
+	}
+
+	Bitboard key = board;
+	if (canonicalKeys)
+		key = canonicalBoard(board);
+	uint64_t slot = canonicalHash(key);
+
+	if (table.contains(key, slot))
+		return false;
+
+	MoveMasks moves;
+	generateMoves(board, moves);
+
+	for (int dir = 0; dir < DIR_COUNT; dir++)
+	{
+		for (Bitboard origins = moves.from[dir]; origins; origins &= origins - 1)
+		{
+			int from = __builtin_ctzll(origins);
+
+			path[depth] = encodeJump(from, dir);
+			if (search(board ^ jumpMask(from, dir), pagodaJump(pagoda, from, dir), depth + 1, path, nodes))
+				return true;
+
+			// Unwind at once once another thread has won or the solve was cancelled
+			if (halted())
+				return false;
+		}
+	}
+
+	// An interrupted search proves nothing about this position
+	if (!halted())
+		table.insert(key, slot);
+
+	return false;
+}
+
+void ParallelSolver::reportWin(const MoveCode *path, int length)
+{
+	bool expected = false;
+
+	if (found.compare_exchange_strong(expected, true))
+	{
+		std::copy(path, path + length, winningPath);
+		winningLength = length;
+	}
+
+	stop = true;
+	wakeIdle();
+}
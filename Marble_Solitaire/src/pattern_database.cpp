@@ -0,0 +1,404 @@
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <deque>
+#include <utility>
+#include <vector>
+
+#include "pattern_database.h"
+#include "symmetry.h"
+
+const char PDB_MAGIC[8] = {'M', 'S', 'P', 'A', 'T', 'T', 'D', 'B'};
+const uint32_t PDB_VERSION = 2;
+const int MAX_REGION_HOLES = 17;
+const int MAX_REGION_SPANS = 5;
+
+struct PdbHeader
+{
+	char magic[8];
+	uint32_t version;
+	uint32_t regions;
+};
+
+// A run of holes on one row: row, first column, width
+struct Span
+{
+	int row, firstCol, width;
+};
+
+/*
+	The board cut along a diagonal through the center: the top and right
+	arms with the center and the cells between them, then the left and
+	bottom arms with the rest. Every hole is in exactly one region.
+*/
+const Span REGION_SPANS[PATTERN_REGIONS][MAX_REGION_SPANS] = {
+	{{0, 2, 3}, {1, 2, 3}, {2, 2, 5}, {3, 3, 4}, {4, 5, 2}},
+	{{2, 0, 2}, {3, 0, 3}, {4, 0, 5}, {5, 2, 3}, {6, 2, 3}},
+};
+
+struct Region
+{
+	Span spans[MAX_REGION_SPANS];
+	int holes[MAX_REGION_HOLES]; // Bit index of each hole, in reading order
+	int count;
+	int8_t local[BOARD_SIZE * BOARD_STRIDE]; // Position of a bit among 'holes', -1 outside the region
+
+	// Table size: every pattern, each with no landing hole or one of the region's own
+	int states() const
+	{
+		return (1 << count) * (count + 1);
+	}
+
+	int index(int pattern, int lastLocal) const
+	{
+		return pattern * (count + 1) + lastLocal + 1;
+	}
+
+	// The region's holes of 'board' as bits 0..count-1, one span at a time
+	int pattern(Bitboard board) const
+	{
+		int bits = 0, shift = 0;
+		for (int i = 0; i < MAX_REGION_SPANS; i++)
+		{
+			bits |= ((board >> cellIndex(spans[i].row, spans[i].firstCol)) & ((1 << spans[i].width) - 1)) << shift;
+			shift += spans[i].width;
+		}
+		return bits;
+	}
+};
+
+struct Regions
+{
+	Region region[PATTERN_REGIONS];
+
+	Regions()
+	{
+		for (int r = 0; r < PATTERN_REGIONS; r++)
+		{
+			Region &region = this->region[r];
+			region.count = 0;
+			memset(region.local, -1, sizeof(region.local));
+
+			for (int i = 0; i < MAX_REGION_SPANS; i++)
+			{
+				const Span &span = REGION_SPANS[r][i];
+				region.spans[i] = span;
+
+				for (int col = span.firstCol; col < span.firstCol + span.width; col++)
+				{
+					region.local[cellIndex(span.row, col)] = region.count;
+					region.holes[region.count++] = cellIndex(span.row, col);
+				}
+			}
+		}
+	}
+};
+
+// The board as it is, then mirrored, which cuts it along the other diagonal
+const int PATTERN_VIEW_SYMMETRIES[PATTERN_VIEWS] = {0, 1};
+
+// Built by the first caller rather than during static initialisation
+static const Regions &regions()
+{
+	static const Regions regions;
+	return regions;
+}
+
+// Both tables of every region
+static size_t tablesSize()
+{
+	size_t size = 0;
+	for (int r = 0; r < PATTERN_REGIONS; r++)
+		size += 2 * regions().region[r].states();
+	return size;
+}
+
+PatternDatabase::PatternDatabase()
+	: mapping(NULL), mappingSize(0)
+{
+	memset(emptyTables, 0, sizeof(emptyTables));
+	memset(singleTables, 0, sizeof(singleTables));
+}
+
+PatternDatabase::~PatternDatabase()
+{
+	close();
+}
+
+bool PatternDatabase::open(const char *fileName)
+{
+	close();
+
+	int fd = ::open(fileName, O_RDONLY);
+	if (fd < 0)
+	{
+		fprintf(stderr, "Error in loading file: '%s'\n", fileName);
+		return false;
+	}
+
+	struct stat info;
+	if (fstat(fd, &info) != 0 || info.st_size < (off_t)sizeof(PdbHeader))
+	{
+		fprintf(stderr, "Pattern database '%s' is truncated\n", fileName);
+		::close(fd);
+		return false;
+	}
+
+	void *data = mmap(NULL, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	::close(fd);
+
+	if (data == MAP_FAILED)
+	{
+		fprintf(stderr, "Could not map pattern database '%s'\n", fileName);
+		return false;
+	}
+
+	const PdbHeader *header = static_cast<const PdbHeader *>(data);
+
+	if (memcmp(header->magic, PDB_MAGIC, sizeof(PDB_MAGIC)) != 0 || header->version != PDB_VERSION ||
+		header->regions != PATTERN_REGIONS || (size_t)info.st_size != sizeof(PdbHeader) + tablesSize())
+	{
+		fprintf(stderr, "Pattern database '%s' has the wrong format\n", fileName);
+		munmap(data, info.st_size);
+		return false;
+	}
+
+	mapping = data;
+	mappingSize = info.st_size;
+
+	const uint8_t *table = static_cast<const uint8_t *>(data) + sizeof(PdbHeader);
+	for (int r = 0; r < PATTERN_REGIONS; r++)
+	{
+		emptyTables[r] = table;
+		singleTables[r] = table + regions().region[r].states();
+		table += 2 * regions().region[r].states();
+	}
+
+	return true;
+}
+
+void PatternDatabase::close()
+{
+	if (mapping)
+		munmap(mapping, mappingSize);
+
+	mapping = NULL;
+	mappingSize = 0;
+	memset(emptyTables, 0, sizeof(emptyTables));
+	memset(singleTables, 0, sizeof(singleTables));
+}
+
+bool PatternDatabase::isLoaded() const
+{
+	return mapping != NULL;
+}
+
+int PatternDatabase::lowerBound(Bitboard board, int last, Bitboard target) const
+{
+	int best = 0;
+
+	// Each view splits the board along a different line; every split gives an admissible bound
+	for (int v = 0; v < PATTERN_VIEWS; v++)
+	{
+		int symmetry = PATTERN_VIEW_SYMMETRIES[v];
+		int imageLast = last >= 0 ? __builtin_ctzll(transformBoard(1ULL << last, symmetry)) : -1;
+		Bitboard imageTarget = target ? transformBoard(target, symmetry) : 0;
+
+		int bound = splitBound(transformBoard(board, symmetry), imageLast, imageTarget);
+		if (bound >= PATTERN_DEAD)
+			return PATTERN_DEAD;
+
+		best = std::max(best, bound);
+	}
+
+	return best;
+}
+
+int PatternDatabase::splitBound(Bitboard board, int last, Bitboard target) const
+{
+	int total = 0;		 // Every region emptied, except a region that cannot be and keeps the last marble
+	int saving = -1;	 // Most saved by finishing in some region instead of emptying it; -1 if none can
+	bool forced = false; // Some region cannot be emptied, so the last marble finishes there
+
+	for (int r = 0; r < PATTERN_REGIONS; r++)
+	{
+		const Region &region = regions().region[r];
+		int index = region.index(region.pattern(board), last >= 0 ? region.local[last] : -1);
+		int empty = emptyTables[r][index];
+		int single = singleTables[r][index];
+
+		// With a target, the last marble can only finish in the target's region
+		bool canFinish = single != PATTERN_DEAD && (target == 0 || region.local[__builtin_ctzll(target)] >= 0);
+
+		if (empty == PATTERN_DEAD)
+		{
+			// No two regions can both keep the last marble
+			if (!canFinish || forced)
+				return PATTERN_DEAD;
+
+			forced = true;
+			total += single;
+		}
+		else
+		{
+			total += empty;
+			if (canFinish)
+				saving = std::max(saving, empty - single);
+		}
+	}
+
+	if (forced)
+		return total;
+
+	return saving < 0 ? PATTERN_DEAD : total - saving;
+}
+
+// A jump touching a region, as the region's own hole numbers: -1 where it leaves the region
+struct LocalJump
+{
+	int from, over, to;
+};
+
+/*
+	Distance of every abstract state to the goal, at most 'goalMarbles'
+	marbles (0 or 1) left in the region. Each jump touching the region is an
+	edge; holes outside the region satisfy whatever the jump needs. The
+	search runs backwards from the goal states, generating the states that
+	lead to each one as it goes instead of storing the reversed edges.
+*/
+static void solveRegion(const Region &region, int goalMarbles, std::vector<uint8_t> &distance)
+{
+	// The jumps touching the region, grouped by where they land: index 0 for outside the region
+	std::vector<std::vector<LocalJump> > landingAt(region.count + 1);
+
+	for (int from = 0; from < BOARD_SIZE * BOARD_STRIDE; from++)
+	{
+		for (int dir = 0; dir < DIR_COUNT; dir++)
+		{
+			int over = from + DIRECTION_STEP[dir];
+			int to = from + 2 * DIRECTION_STEP[dir];
+
+			// Off the board, or wrapping round a row end onto the unused eighth column
+			if (to < 0 || to >= BOARD_SIZE * BOARD_STRIDE || (jumpMask(from, dir) & ~VALID_HOLES) != 0)
+				continue;
+
+			LocalJump jump = {region.local[from], region.local[over], region.local[to]};
+			if (jump.from >= 0 || jump.over >= 0 || jump.to >= 0)
+				landingAt[jump.to + 1].push_back(jump);
+		}
+	}
+
+	distance.assign(region.states(), PATTERN_DEAD);
+	std::deque<int> queue;
+
+	for (int pattern = 0; pattern < (1 << region.count); pattern++)
+	{
+		if (__builtin_popcount(pattern) > goalMarbles)
+			continue;
+
+		for (int lastLocal = -1; lastLocal < region.count; lastLocal++)
+		{
+			distance[region.index(pattern, lastLocal)] = 0;
+			queue.push_back(region.index(pattern, lastLocal));
+		}
+	}
+
+	while (!queue.empty())
+	{
+		int state = queue.front();
+		queue.pop_front();
+
+		int pattern = state / (region.count + 1);
+		int lastLocal = state % (region.count + 1) - 1;
+		const std::vector<LocalJump> &jumps = landingAt[lastLocal + 1];
+
+		for (size_t j = 0; j < jumps.size(); j++)
+		{
+			const LocalJump &jump = jumps[j];
+
+			// After the jump its landing hole is full and the other two are empty
+			if ((jump.to >= 0 && !((pattern >> jump.to) & 1)) || (jump.from >= 0 && ((pattern >> jump.from) & 1)) ||
+				(jump.over >= 0 && ((pattern >> jump.over) & 1)))
+				continue;
+
+			int previous = pattern;
+			if (jump.to >= 0)
+				previous &= ~(1 << jump.to);
+			if (jump.from >= 0)
+				previous |= 1 << jump.from;
+			if (jump.over >= 0)
+				previous |= 1 << jump.over;
+
+			// Charged here only when the move starts here; a chain from the landing hole is free
+			for (int previousLast = -1; previousLast < region.count; previousLast++)
+			{
+				int cost = jump.from >= 0 && jump.from != previousLast ? 1 : 0;
+				int before = region.index(previous, previousLast);
+
+				if (distance[state] + cost >= distance[before])
+					continue;
+
+				distance[before] = distance[state] + cost;
+				if (cost == 0)
+					queue.push_front(before);
+				else
+					queue.push_back(before);
+			}
+		}
+	}
+}
+
+bool buildPatternDatabase(const char *fileName, FILE *log)
+{
+	std::vector<uint8_t> tables;
+
+	for (int r = 0; r < PATTERN_REGIONS; r++)
+	{
+		const Region &region = regions().region[r];
+
+		for (int goalMarbles = 0; goalMarbles <= 1; goalMarbles++)
+		{
+			std::vector<uint8_t> distance;
+			solveRegion(region, goalMarbles, distance);
+
+			int largest = 0, dead = 0;
+			for (size_t i = 0; i < distance.size(); i++)
+			{
+				if (distance[i] == PATTERN_DEAD)
+					dead++;
+				else if (distance[i] > largest)
+					largest = distance[i];
+			}
+
+			fprintf(log, "region %d, %s: %d holes, %7d states, at most %d moves, %d dead\n", r,
+					goalMarbles == 0 ? "empty " : "single", region.count, region.states(), largest, dead);
+
+			tables.insert(tables.end(), distance.begin(), distance.end());
+		}
+	}
+
+	FILE *file = fopen(fileName, "wb");
+	if (!file)
+	{
+		fprintf(stderr, "Could not write '%s'\n", fileName);
+		return false;
+	}
+
+	PdbHeader header;
+	memcpy(header.magic, PDB_MAGIC, sizeof(PDB_MAGIC));
+	header.version = PDB_VERSION;
+	header.regions = PATTERN_REGIONS;
+
+	bool ok = fwrite(&header, sizeof(header), 1, file) == 1 && fwrite(tables.data(), 1, tables.size(), file) == tables.size();
+
+	if (fclose(file) != 0 || !ok)
+	{
+		fprintf(stderr, "Could not write '%s'\n", fileName);
+		return false;
+	}
+
+	return true;
+}
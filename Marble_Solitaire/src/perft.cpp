@@ -0,0 +1,134 @@
+#include <atomic>
+#include <functional>
+#include <thread>
+#include <vector>
+
+#include "perft.h"
+#include "rules.h"
+
+// Checked against an independent coordinate-based implementation
+const uint64_t STANDARD_PERFT[] = {
+	1ULL,
+	4ULL,
+	12ULL,
+	60ULL,
+	400ULL,
+	2960ULL,
+	24600ULL,
+	221072ULL,
+	2076744ULL,
+	20123080ULL,
+	197757768ULL,
+	1937125160ULL,
+};
+
+const int STANDARD_PERFT_DEPTHS = sizeof(STANDARD_PERFT) / sizeof(STANDARD_PERFT[0]);
+
+// Work items per thread when splitting, so threads that draw small subtrees pick up more
+const size_t TASKS_PER_THREAD = 64;
+
+uint64_t perft(Bitboard board, int depth)
+{
+	if (depth == 0)
+		return 1;
+
+	MoveMasks moves;
+	generateMoves(board, moves);
+
+	if (depth == 1)
+		return countMoves(moves);
+
+	uint64_t nodes = 0;
+
+	for (int dir = 0; dir < DIR_COUNT; dir++)
+	{
+		for (Bitboard origins = moves.from[dir]; origins; origins &= origins - 1)
+			nodes += perft(board ^ jumpMask(__builtin_ctzll(origins), dir), depth - 1);
+	}
+
+	return nodes;
+}
+
+uint64_t perftNaive(Bitboard board, int depth)
+{
+	if (depth == 0)
+		return 1;
+
+	uint64_t nodes = 0;
+
+	for (int row = 0; row < BOARD_SIZE; row++)
+	{
+		for (int col = 0; col < BOARD_SIZE; col++)
+		{
+			for (int dir = 0; dir < DIR_COUNT; dir++)
+			{
+				int step = DIRECTION_STEP[dir];
+				Position from = {row, col};
+				Position to = {row + 2 * (step / BOARD_STRIDE), col + 2 * (step % BOARD_STRIDE)};
+
+				if (validateMove(board, from, to) == NONE)
+					nodes += perftNaive(board ^ moveMask(makeJump(from, to)), depth - 1);
+			}
+		}
+	}
+
+	return nodes;
+}
+
+// Every position exactly 'depth' jumps from 'board', one entry per move sequence
+static void expand(Bitboard board, int depth, std::vector<Bitboard> &frontier)
+{
+	if (depth == 0)
+	{
+		frontier.push_back(board);
+		return;
+	}
+
+	MoveMasks moves;
+	generateMoves(board, moves);
+
+	for (int dir = 0; dir < DIR_COUNT; dir++)
+	{
+		for (Bitboard origins = moves.from[dir]; origins; origins &= origins - 1)
+			expand(board ^ jumpMask(__builtin_ctzll(origins), dir), depth - 1, frontier);
+	}
+}
+
+// Draw subtrees from the shared frontier until it runs dry
+static void perftWorker(const std::vector<Bitboard> &frontier, int depth, std::atomic<size_t> &next, std::atomic<uint64_t> &total)
+{
+	uint64_t nodes = 0;
+
+	for (size_t task = next++; task < frontier.size(); task = next++)
+		nodes += perft(frontier[task], depth);
+
+	total += nodes;
+}
+
+uint64_t parallelPerft(Bitboard board, int depth, int threads)
+{
+	// Split a few plies down until there are enough subtrees to share out
+	std::vector<Bitboard> frontier(1, board);
+	int splitDepth = 0;
+
+	while (splitDepth < depth && !frontier.empty() && frontier.size() < threads * TASKS_PER_THREAD)
+	{
+		splitDepth++;
+		frontier.clear();
+		expand(board, splitDepth, frontier);
+	}
+
+	std::atomic<size_t> next(0);
+	std::atomic<uint64_t> total(0);
+	std::vector<std::thread> workers;
+
+	for (int i = 0; i < threads; i++)
+	{
+		workers.push_back(std::thread(perftWorker, std::cref(frontier), depth - splitDepth, std::ref(next), std::ref(total)));
+	}
+
+	for (size_t i = 0; i < workers.size(); i++)
+		workers[i].join();
+
+	return total;
+}
@@ -0,0 +1,83 @@
+#include <stdlib.h>
+
+#include "rules.h"
+
+MoveError validateMove(Bitboard board, Position from, Position to)
+{
+	if (!isBoardHole(from.row, from.col) || !hasMarble(board, from.row, from.col))
+		return NO_MARBLE_SELECTED;
+
+	if (!isBoardHole(to.row, to.col))
+		return DESTINATION_OFF_BOARD;
+
+	if (hasMarble(board, to.row, to.col))
+		return DESTINATION_NOT_EMPTY;
+
+	int rowDiff = abs(to.row - from.row);
+	int colDiff = abs(to.col - from.col);
+
+	if ((rowDiff == 2 && colDiff == 0) || (rowDiff == 0 && colDiff == 2))
+	{
+		int middleRow = (from.row + to.row) / 2;
+		int middleCol = (from.col + to.col) / 2;
+
+		if (hasMarble(board, middleRow, middleCol))
+			return NONE;
+
+		return NO_MARBLE_TO_JUMP;
+	}
+
+	return INVALID_DISTANCE;
+}
+
+Move makeJump(Position from, Position to)
+{
+	Move move = {from, to, {(from.row + to.row) / 2, (from.col + to.col) / 2}};
+	return move;
+}
+
+Bitboard moveMask(const Move &move)
+{
+	return cellBit(move.from.row, move.from.col) |
+		   cellBit(move.captured.row, move.captured.col) |
+		   cellBit(move.to.row, move.to.col);
+}
+
+MoveCode encodeMove(const Move &move)
+{
+	int dir;
+
+	if (move.to.row < move.from.row)
+		dir = DIR_UP;
+	else if (move.to.row > move.from.row)
+		dir = DIR_DOWN;
+	else if (move.to.col < move.from.col)
+		dir = DIR_LEFT;
+	else
+		dir = DIR_RIGHT;
+
+	return encodeJump(cellIndex(move.from.row, move.from.col), dir);
+}
+
+Move decodeMove(MoveCode code)
+{
+	int from = jumpOrigin(code);
+	int to = from + 2 * DIRECTION_STEP[jumpDirection(code)];
+	Position fromPos = {from / BOARD_STRIDE, from % BOARD_STRIDE};
+	Position toPos = {to / BOARD_STRIDE, to % BOARD_STRIDE};
+
+	return makeJump(fromPos, toPos);
+}
+
+GameStatus evaluateStatus(Bitboard board)
+{
+	int marbles = countMarbles(board);
+
+	if (marbles == 1)
+		return WON;
+
+	if (marbles > 1 && !hasAnyMove(board))
+		return LOST;
+
+	return PLAYING;
+}
@@ -0,0 +1,285 @@
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <vector>
+
+#include "solvability_db.h"
+#include "symmetry.h"
+
+const char DB_MAGIC[8] = {'M', 'S', 'S', 'O', 'L', 'V', 'D', 'B'};
+const uint32_t DB_VERSION = 1;
+
+// About 1.7M entries: 2^20 buckets keeps them to one or two entries each
+const int DB_BUCKET_BITS = 20;
+
+struct DbHeader
+{
+	char magic[8];
+	uint32_t version;
+	uint32_t bucketBits;
+	uint64_t entryCount;
+};
+
+static uint64_t bucketOf(Bitboard canonical, int bucketBits)
+{
+	return canonicalHash(canonical) >> (64 - bucketBits);
+}
+
+// Offset of the entry array: header, then 2^bits + 1 bucket offsets, padded to 8 bytes
+static size_t entriesOffset(int bucketBits)
+{
+	size_t offset = sizeof(DbHeader) + ((1ULL << bucketBits) + 1) * sizeof(uint32_t);
+	return (offset + 7) & ~(size_t)7;
+}
+
+SolvabilityDatabase::SolvabilityDatabase()
+	: mapping(NULL), mappingSize(0), bucketBits(0), buckets(NULL), entries(NULL), entryCount(0)
+{
+}
+
+SolvabilityDatabase::~SolvabilityDatabase()
+{
+	close();
+}
+
+bool SolvabilityDatabase::open(const char *fileName)
+{
+	close();
+
+	int fd = ::open(fileName, O_RDONLY);
+	if (fd < 0)
+	{
+		fprintf(stderr, "Error in loading file: '%s'\n", fileName);
+		return false;
+	}
+
+	struct stat info;
+	if (fstat(fd, &info) != 0 || info.st_size < (off_t)sizeof(DbHeader))
+	{
+		fprintf(stderr, "Solvability database '%s' is truncated\n", fileName);
+		::close(fd);
+		return false;
+	}
+
+	void *data = mmap(NULL, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	::close(fd);
+
+	if (data == MAP_FAILED)
+	{
+		fprintf(stderr, "Could not map solvability database '%s'\n", fileName);
+		return false;
+	}
+
+	const DbHeader *header = static_cast<const DbHeader *>(data);
+
+	// Range-check bucketBits before it sizes anything, and the entry count against the bytes left for it
+	bool valid = memcmp(header->magic, DB_MAGIC, sizeof(DB_MAGIC)) == 0 && header->version == DB_VERSION &&
+				 header->bucketBits >= 1 && header->bucketBits <= 30 &&
+				 (size_t)info.st_size >= entriesOffset(header->bucketBits);
+
+	if (valid)
+	{
+		size_t offset = entriesOffset(header->bucketBits);
+		size_t room = ((size_t)info.st_size - offset) / sizeof(Bitboard);
+		valid = header->entryCount == room && (size_t)info.st_size == offset + room * sizeof(Bitboard);
+	}
+
+	// isWinnable scans buckets[b]..buckets[b + 1]: offsets must never decrease and must end at entryCount
+	if (valid)
+	{
+		const uint32_t *offsets = reinterpret_cast<const uint32_t *>(static_cast<const char *>(data) + sizeof(DbHeader));
+		uint64_t bucketCount = 1ULL << header->bucketBits;
+
+		valid = offsets[0] == 0 && offsets[bucketCount] == header->entryCount;
+		for (uint64_t b = 0; valid && b < bucketCount; b++)
+			valid = offsets[b] <= offsets[b + 1];
+	}
+
+	if (!valid)
+	{
+		fprintf(stderr, "Solvability database '%s' has the wrong format\n", fileName);
+		munmap(data, info.st_size);
+		return false;
+	}
+
+	mapping = data;
+	mappingSize = info.st_size;
+	bucketBits = header->bucketBits;
+	buckets = reinterpret_cast<const uint32_t *>(static_cast<const char *>(data) + sizeof(DbHeader));
+	entries = reinterpret_cast<const Bitboard *>(static_cast<const char *>(data) + entriesOffset(bucketBits));
+	entryCount = header->entryCount;
+	return true;
+}
+
+void SolvabilityDatabase::close()
+{
+	if (mapping)
+		munmap(mapping, mappingSize);
+
+	mapping = NULL;
+	mappingSize = 0;
+	buckets = NULL;
+	entries = NULL;
+	entryCount = 0;
+}
+
+bool SolvabilityDatabase::isLoaded() const
+{
+	return mapping != NULL;
+}
+
+bool SolvabilityDatabase::isWinnable(Bitboard board) const
+{
+	if (!mapping)
+		return false;
+
+	Bitboard canonical = canonicalBoard(board);
+	uint64_t bucket = bucketOf(canonical, bucketBits);
+
+	for (uint32_t i = buckets[bucket]; i < buckets[bucket + 1]; i++)
+	{
+		if (entries[i] == canonical)
+			return true;
+	}
+
+	return false;
+}
+
+uint64_t SolvabilityDatabase::size() const
+{
+	return entryCount;
+}
+
+// Canonical successors of every position in 'layer', sorted and without duplicates
+static void expandLayer(const std::vector<Bitboard> &layer, std::vector<Bitboard> &next)
+{
+	next.clear();
+
+	for (size_t i = 0; i < layer.size(); i++)
+	{
+		MoveMasks moves;
+		generateMoves(layer[i], moves);
+
+		for (int dir = 0; dir < DIR_COUNT; dir++)
+		{
+			for (Bitboard origins = moves.from[dir]; origins; origins &= origins - 1)
+				next.push_back(canonicalBoard(layer[i] ^ jumpMask(__builtin_ctzll(origins), dir)));
+		}
+	}
+
+	std::sort(next.begin(), next.end());
+	next.erase(std::unique(next.begin(), next.end()), next.end());
+}
+
+// True if some move from 'board' lands in the sorted set 'winnable'
+static bool reachesWinnable(Bitboard board, const std::vector<Bitboard> &winnable)
+{
+	MoveMasks moves;
+	generateMoves(board, moves);
+
+	for (int dir = 0; dir < DIR_COUNT; dir++)
+	{
+		for (Bitboard origins = moves.from[dir]; origins; origins &= origins - 1)
+		{
+			Bitboard next = canonicalBoard(board ^ jumpMask(__builtin_ctzll(origins), dir));
+			if (std::binary_search(winnable.begin(), winnable.end(), next))
+				return true;
+		}
+	}
+
+	return false;
+}
+
+static bool bucketLess(Bitboard a, Bitboard b)
+{
+	uint64_t bucketA = bucketOf(a, DB_BUCKET_BITS);
+	uint64_t bucketB = bucketOf(b, DB_BUCKET_BITS);
+	return bucketA < bucketB || (bucketA == bucketB && a < b);
+}
+
+bool buildSolvabilityDatabase(const char *fileName, FILE *log)
+{
+	// Forward: all reachable positions, one layer per marble count
+	std::vector<std::vector<Bitboard> > layers(1, std::vector<Bitboard>(1, canonicalBoard(START_POSITION)));
+	uint64_t reachable = 1;
+
+	while (true)
+	{
+		fprintf(log, "%2d marbles: %9zu positions\n", countMarbles(layers.back()[0]), layers.back().size());
+
+		std::vector<Bitboard> next;
+		expandLayer(layers.back(), next);
+
+		if (next.empty())
+			break;
+
+		reachable += next.size();
+		layers.push_back(std::vector<Bitboard>());
+		layers.back().swap(next);
+	}
+
+	fprintf(log, "reachable: %llu positions up to symmetry\n", (unsigned long long)reachable);
+
+	// Backward: a position is winnable if one move reaches a winnable position
+	std::vector<Bitboard> all;
+	std::vector<Bitboard> winnable;
+
+	for (int i = layers.size() - 1; i >= 0; i--)
+	{
+		std::vector<Bitboard> marked;
+
+		for (size_t j = 0; j < layers[i].size(); j++)
+		{
+			Bitboard board = layers[i][j];
+			if ((board & (board - 1)) == 0 || reachesWinnable(board, winnable))
+				marked.push_back(board);
+		}
+
+		all.insert(all.end(), marked.begin(), marked.end());
+		winnable.swap(marked);
+		std::vector<Bitboard>().swap(layers[i]);
+	}
+
+	fprintf(log, "winnable:  %zu positions up to symmetry\n", all.size());
+
+	// Bucket the entries by hash so a lookup only scans its own bucket
+	std::sort(all.begin(), all.end(), bucketLess);
+
+	std::vector<uint32_t> buckets((1ULL << DB_BUCKET_BITS) + 1, 0);
+	for (size_t i = 0; i < all.size(); i++)
+		buckets[bucketOf(all[i], DB_BUCKET_BITS) + 1]++;
+	for (size_t i = 1; i < buckets.size(); i++)
+		buckets[i] += buckets[i - 1];
+
+	FILE *file = fopen(fileName, "wb");
+	if (!file)
+	{
+		fprintf(stderr, "Could not write '%s'\n", fileName);
+		return false;
+	}
+
+	DbHeader header;
+	memcpy(header.magic, DB_MAGIC, sizeof(DB_MAGIC));
+	header.version = DB_VERSION;
+	header.bucketBits = DB_BUCKET_BITS;
+	header.entryCount = all.size();
+
+	size_t padding = entriesOffset(DB_BUCKET_BITS) - sizeof(header) - buckets.size() * sizeof(uint32_t);
+	const char zeros[8] = {0};
+
+	bool ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+			  fwrite(&buckets[0], sizeof(uint32_t), buckets.size(), file) == buckets.size() &&
+			  fwrite(zeros, 1, padding, file) == padding &&
+			  fwrite(&all[0], sizeof(Bitboard), all.size(), file) == all.size();
+
+	if (fclose(file) != 0 || !ok)
+	{
+		fprintf(stderr, "Could not write '%s'\n", fileName);
+		return false;
+	}
+
+	return true;
+}
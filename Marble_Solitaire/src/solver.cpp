@@ -0,0 +1,201 @@
+#include <algorithm>
+
+#include "solver.h"
+#include "position_class.h"
+#include "zobrist.h"
+#include "symmetry.h"
+
+// Number of slots examined before a lookup gives up or an insert overwrites
+const int PROBE_WINDOW = 4;
+
+// How many nodes are searched between checks of the cancel flag and the clock
+const uint64_t ABORT_CHECK_INTERVAL = 4096;
+
+TranspositionTable::TranspositionTable(int sizeBits)
+	: slots(1ULL << sizeBits, 0), mask((1ULL << sizeBits) - 1)
+{
+}
+
+bool TranspositionTable::contains(Bitboard board, uint64_t hash) const
+{
+	for (int i = 0; i < PROBE_WINDOW; i++)
+	{
+		Bitboard slot = slots[(hash + i) & mask];
+
+		if (slot == board)
+			return true;
+		if (slot == 0)
+			return false;
+	}
+
+	return false;
+}
+
+void TranspositionTable::insert(Bitboard board, uint64_t hash)
+{
+	for (int i = 0; i < PROBE_WINDOW; i++)
+	{
+		Bitboard &slot = slots[(hash + i) & mask];
+
+		if (slot == 0 || slot == board)
+		{
+			slot = board;
+			return;
+		}
+	}
+
+	// Window full: replace a slot picked by the high hash bits
+	slots[(hash + (hash >> 62)) & mask] = board;
+}
+
+void TranspositionTable::clear()
+{
+	std::fill(slots.begin(), slots.end(), 0);
+}
+
+Solver::Solver(int tableBits, bool useSymmetry)
+	: table(tableBits), useSymmetry(useSymmetry), canonicalKeys(false), target(0), finishes(VALID_HOLES), nodeCount(0),
+	  tablebase(NULL), tablebaseMarbles(0), cancel(NULL), timeLimit(0.0), stopped(false)
+{
+}
+
+bool Solver::solve(Bitboard board, std::vector<Move> &solution, Bitboard target)
+{
+	// Known-lost positions are only lost with respect to one target
+	if (this->target != target)
+		table.clear();
+
+	this->target = target;
+
+	// Holes the last marble may end on; the class invariant rules out the rest before any search
+	finishes = (target ? target : VALID_HOLES) & classFinishes(board);
+
+	// Symmetric images of a position are only equivalent when the target is symmetric too
+	canonicalKeys = useSymmetry && isSymmetric(target);
+	nodeCount = 0;
+	stopped = false;
+	solution.clear();
+
+	if (finishes == 0)
+		return false;
+
+	if (timeLimit > 0.0)
+		deadline = std::chrono::steady_clock::now() +
+				   std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(timeLimit));
+
+	if (!search(board, zobristHash(board), pagodaValues(board), 0))
+		return false;
+
+	int moves = countMarbles(board) - 1;
+	for (int i = 0; i < moves; i++)
+		solution.push_back(decodeMove(line[i]));
+	return true;
+}
+
+bool Solver::solve(Bitboard board, Bitboard target)
+{
+	std::vector<Move> solution;
+	return solve(board, solution, target);
+}
+
+uint64_t Solver::nodes() const
+{
+	return nodeCount;
+}
+
+void Solver::clear()
+{
+	table.clear();
+}
+
+void Solver::setCancelFlag(const std::atomic<bool> *cancel)
+{
+	this->cancel = cancel;
+}
+
+void Solver::setTimeLimit(double seconds)
+{
+	timeLimit = seconds;
+}
+
+bool Solver::aborted() const
+{
+	return stopped;
+}
+
+void Solver::setTablebase(const EndgameTablebase *tablebase)
+{
+	this->tablebase = tablebase;
+	tablebaseMarbles = tablebase && tablebase->isLoaded() ? tablebase->maxMarbles() : 0;
+}
+
+bool Solver::checkAbort()
+{
+	if ((cancel && cancel->load(std::memory_order_relaxed)) ||
+		(timeLimit > 0.0 && std::chrono::steady_clock::now() >= deadline))
+	{
+		stopped = true;
+	}
+
+	return stopped;
+}
+
+bool Solver::search(Bitboard board, uint64_t hash, PagodaValues pagoda, int depth)
+{
+	if (++nodeCount % ABORT_CHECK_INTERVAL == 0 && checkAbort())
+		return false;
+
+	// A single marble left
+	if ((board & (board - 1)) == 0)
+		return target == 0 || board == target;
+
+	if ((pagodaFinishes(pagoda) & finishes) == 0)
+		return false;
+
+	// Lost anywhere means lost on the target too; a win anywhere only settles untargeted searches
+	if (countMarbles(board) <= tablebaseMarbles)
+	{
+		if (!tablebase->isWinnable(board))
+			return false;
+
+		// No line from a table that contradicts itself: search on instead
+		if (target == 0 && tablebase->winningLine(board, line + depth) >= 0)
+			return true;
+	}
+
+	Bitboard key = board;
+	uint64_t slot = hash;
+
+	// Recomputed at every node: the incremental hash only follows the board as played
+	if (canonicalKeys)
+	{
+		key = canonicalBoard(board);
+		slot = canonicalHash(key);
+	}
+
+	if (table.contains(key, slot))
+		return false;
+
+	MoveMasks moves;
+	generateMoves(board, moves);
+
+	for (int dir = 0; dir < DIR_COUNT; dir++)
+	{
+		for (Bitboard origins = moves.from[dir]; origins; origins &= origins - 1)
+		{
+			int from = __builtin_ctzll(origins);
+
+			if (search(board ^ jumpMask(from, dir), hash ^ zobristJump(from, dir), pagodaJump(pagoda, from, dir), depth + 1))
+			{
+				line[depth] = encodeJump(from, dir);
+				return true;
+			}
+
+			if (stopped)
+				return false;
+		}
+	}
+
+	table.insert(key, slot);
+	return false;
+}
@@ -0,0 +1,21 @@
+#include "zobrist.h"
+
+// Fixed splitmix64 output so hashes are identical across runs and machines
+const uint64_t ZOBRIST_KEYS[64] = {
+	0x19cdbdcda3454312ULL, 0xdfbe4d78b2405766ULL, 0xe21ab4d9964cb0f5ULL, 0x7ce6e51ee6db3027ULL,
+	0xe7c592f5a8178395ULL, 0xcd645a4a9fe0af4dULL, 0xa76a1f7423263e21ULL, 0xcc802caf1745210bULL,
+	0x911a2b7571c35a76ULL, 0x52c37f122cf950edULL, 0x4956c13fe63f5d29ULL, 0xdd284d4d397620daULL,
+	0xb13be17095cea915ULL, 0xc8e239d414bcff5aULL, 0x9660a882c2eecc0cULL, 0x7db66b67eb2f92f2ULL,
+	0x991a2b4d3d87ba80ULL, 0x4c4e5b3c6907ddfeULL, 0xc03945b79d2bc036ULL, 0x20e31e3923ffdbb4ULL,
+	0x73ec1d0522988d9aULL, 0x62d3409c8ed29c2eULL, 0xf4bde26c3c5e2f10ULL, 0xd43464687f8fabaeULL,
+	0x975c437f976e4b52ULL, 0xd9c8c7f67e6677f8ULL, 0x1f7f1dc0196fb429ULL, 0xbcf5169b5c086fc2ULL,
+	0x0bb2d1e62152439bULL, 0x05bd906902bb8521ULL, 0x9756065263e18da9ULL, 0x5724199b1a54e7afULL,
+	0x01503da4a45020aaULL, 0x9b29e9df844066e0ULL, 0xb8a09fa6ab9eea89ULL, 0xe0fc569199f3fee0ULL,
+	0x44be6399edac3137ULL, 0x1ed37b553c95a783ULL, 0x7828c794485d71bdULL, 0x196440bd66869ab7ULL,
+	0x249b6cd834b20812ULL, 0xe43ebfcbb2e7fa78ULL, 0x3a8ba7506e3194f3ULL, 0x0f30c2ac91c77820ULL,
+	0xb5d36900e24ce639ULL, 0xa4df538ed998eceeULL, 0x5e9991dd67f49a58ULL, 0xf91a628c21853d2dULL,
+	0x4cdde0f218357d53ULL, 0x629fb089067ca793ULL, 0x68b6ba5fa0064abeULL, 0x657186b433093acdULL,
+	0xa3349db35a7e52dcULL, 0xdbb3299a94202ec4ULL, 0xa1c9049a87d9ca53ULL, 0x05dc90729dbdf286ULL,
+	0xd63cb6a86cb06a2aULL, 0x39cbfba071770f0eULL, 0x7bf71ea429150e17ULL, 0xbfff48f67cdad3f6ULL,
+	0xabd722b259cfab3fULL, 0x187714f4ce873561ULL, 0xea745d027100dc74ULL, 0x531e4061dce0bc85ULL,
+};
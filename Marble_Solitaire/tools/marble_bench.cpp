@@ -0,0 +1,339 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_CYCLE_COUNTER 1
+#else
+#define HAVE_CYCLE_COUNTER 0
+#endif
+
+#include "bitboard.h"
+#include "board_layout.h"
+#include "game.h"
+#include "math_utils.h"
+#include "rules.h"
+
+using namespace std;
+
+/********************************************************************
+  Microbenchmarks for the rules and renderer hot paths. Every input set
+  is generated from a fixed seed, so two runs (or two commits) time
+  exactly the same work; results go to stdout as JSON for diffing.
+ */
+
+const uint64_t DEFAULT_SEED = 0x6d617262;
+const int DEFAULT_SAMPLES = 2000;
+const int INPUT_COUNT = 4096; // Inputs per set, cycled through by every benchmark
+const int BATCH = 256;		  // Operations per timed sample
+const int WINDOW_WIDTH = 800;
+const int WINDOW_HEIGHT = 600;
+
+// Defeats dead-code elimination: every benchmark folds its results in here
+volatile uint64_t sink;
+
+// A float's bits, for folding into sink without a float-to-integer conversion (undefined when out of range)
+static uint32_t floatBits(float value)
+{
+	uint32_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+	return bits;
+}
+
+struct Random
+{
+	uint64_t state;
+
+	// splitmix64: identical sequences on every platform, unlike rand()
+	uint64_t next()
+	{
+		uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+		z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+		z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+		return z ^ (z >> 31);
+	}
+
+	int below(int n)
+	{
+		return static_cast<int>(next() % n);
+	}
+
+	float uniform(float low, float high)
+	{
+		return low + (high - low) * (next() >> 40) / float(1 << 24);
+	}
+};
+
+struct Result
+{
+	const char *name;
+	double nsPerOp;
+	double p50, p90, p99, min, max;
+	double cyclesPerOp;
+};
+
+static inline uint64_t readCycles()
+{
+#if HAVE_CYCLE_COUNTER
+	return __rdtsc();
+#else
+	return 0;
+#endif
+}
+
+/*
+	Times 'samples' batches of BATCH calls to op(i), i running on through the
+	input set. Percentiles are over per-batch ns/op, so they show jitter
+	between batches rather than single calls, which are too short to time.
+*/
+template <typename Op>
+static Result measure(const char *name, int samples, Op op)
+{
+	vector<double> ns(samples);
+	uint64_t cycles = 0;
+	double totalNs = 0;
+	int index = 0;
+
+	// Warm caches and branch predictors on one pass over the inputs
+	for (int i = 0; i < INPUT_COUNT; i++)
+		op(i);
+
+	for (int s = 0; s < samples; s++)
+	{
+		chrono::steady_clock::time_point start = chrono::steady_clock::now();
+		uint64_t startCycles = readCycles();
+
+		for (int i = 0; i < BATCH; i++)
+		{
+			op(index);
+			index = (index + 1) % INPUT_COUNT;
+		}
+
+		cycles += readCycles() - startCycles;
+		double elapsed = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count();
+		ns[s] = elapsed / BATCH;
+		totalNs += elapsed;
+	}
+
+	sort(ns.begin(), ns.end());
+
+	Result result;
+	result.name = name;
+	result.nsPerOp = totalNs / (double(samples) * BATCH);
+	result.p50 = ns[samples / 2];
+	result.p90 = ns[samples * 9 / 10];
+	result.p99 = ns[samples * 99 / 100];
+	result.min = ns.front();
+	result.max = ns.back();
+	result.cyclesPerOp = double(cycles) / (double(samples) * BATCH);
+	return result;
+}
+
+// The legal jump 'k' of 'board' (counting in generation order), or false if there are fewer
+static bool nthMove(Bitboard board, int k, Position &from, Position &to)
+{
+	MoveMasks moves;
+	generateMoves(board, moves);
+
+	for (int dir = 0; dir < DIR_COUNT; dir++)
+	{
+		for (Bitboard origins = moves.from[dir]; origins; origins &= origins - 1)
+		{
+			if (k-- > 0)
+				continue;
+
+			int origin = __builtin_ctzll(origins);
+			int landing = origin + 2 * DIRECTION_STEP[dir];
+			from.row = origin / BOARD_STRIDE;
+			from.col = origin % BOARD_STRIDE;
+			to.row = landing / BOARD_STRIDE;
+			to.col = landing % BOARD_STRIDE;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+// A game of random legal moves, stopped after 'length' moves or when it gets stuck
+static void randomGame(Random &random, int length, Game &game)
+{
+	game.reset();
+
+	for (int i = 0; i < length && game.legalMoveCount > 0; i++)
+	{
+		Position from, to;
+		nthMove(game.board, random.below(game.legalMoveCount), from, to);
+		game.makeMove(from, to);
+	}
+}
+
+static Position randomHole(Random &random)
+{
+	Position position;
+
+	do
+	{
+		position.row = random.below(BOARD_SIZE);
+		position.col = random.below(BOARD_SIZE);
+	} while (!isBoardHole(position.row, position.col));
+
+	return position;
+}
+
+static Matrix4f randomMatrix(Random &random)
+{
+	Matrix4f matrix;
+
+	for (int i = 0; i < 4; i++)
+	{
+		for (int j = 0; j < 4; j++)
+			matrix.m[i][j] = random.uniform(-1.0f, 1.0f);
+	}
+
+	// Diagonally dominant, so always invertible, like the model matrices the renderer builds
+	for (int i = 0; i < 4; i++)
+		matrix.m[i][i] += 4.0f;
+
+	return matrix;
+}
+
+static void printJson(uint64_t seed, int samples, const vector<Result> &results)
+{
+	printf("{\n");
+	printf("  \"seed\": %llu,\n", (unsigned long long)seed);
+	printf("  \"samples\": %d,\n", samples);
+	printf("  \"batch\": %d,\n", BATCH);
+	printf("  \"cycle_counter\": %s,\n", HAVE_CYCLE_COUNTER ? "\"rdtsc\"" : "null");
+	printf("  \"benchmarks\": [\n");
+
+	for (size_t i = 0; i < results.size(); i++)
+	{
+		const Result &r = results[i];
+		printf("    {\"name\": \"%s\", \"ns_per_op\": %.3f, \"p50\": %.3f, \"p90\": %.3f, \"p99\": %.3f, "
+			   "\"min\": %.3f, \"max\": %.3f, \"cycles_per_op\": ",
+			   r.name, r.nsPerOp, r.p50, r.p90, r.p99, r.min, r.max);
+
+		if (HAVE_CYCLE_COUNTER)
+			printf("%.2f}", r.cyclesPerOp);
+		else
+			printf("null}");
+
+		printf("%s\n", i + 1 < results.size() ? "," : "");
+	}
+
+	printf("  ]\n");
+	printf("}\n");
+}
+
+int main(int argc, char *argv[])
+{
+	uint64_t seed = DEFAULT_SEED;
+	int samples = DEFAULT_SAMPLES;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+			seed = strtoull(argv[++i], NULL, 0);
+		else if (strcmp(argv[i], "--samples") == 0 && i + 1 < argc && atoi(argv[i + 1]) > 0)
+			samples = atoi(argv[++i]);
+		else
+		{
+			fprintf(stderr, "usage: marble_bench [--seed S] [--samples N]\n");
+			return 1;
+		}
+	}
+
+	Random random = {seed};
+
+	// Positions from random games of every length, each with one legal move and one arbitrary query
+	vector<Game> games(INPUT_COUNT);
+	vector<Bitboard> boards(INPUT_COUNT);
+	vector<Position> legalFrom(INPUT_COUNT), legalTo(INPUT_COUNT);
+	vector<Position> queryFrom(INPUT_COUNT), queryTo(INPUT_COUNT);
+
+	for (int i = 0; i < INPUT_COUNT; i++)
+	{
+		// Keep at least one legal move, so every game has something to make and undo
+		do
+			randomGame(random, random.below(MAX_GAME_MOVES), games[i]);
+		while (games[i].legalMoveCount == 0);
+
+		boards[i] = games[i].board;
+		nthMove(boards[i], random.below(games[i].legalMoveCount), legalFrom[i], legalTo[i]);
+
+		// A hole and one of the four spots two steps away, on the board or not: mostly illegal
+		queryFrom[i] = randomHole(random);
+		int step = DIRECTION_STEP[random.below(DIR_COUNT)];
+		queryTo[i].row = queryFrom[i].row + 2 * (step / BOARD_STRIDE);
+		queryTo[i].col = queryFrom[i].col + 2 * (step % BOARD_STRIDE);
+	}
+
+	vector<double> pixelX(INPUT_COUNT), pixelY(INPUT_COUNT);
+	for (int i = 0; i < INPUT_COUNT; i++)
+	{
+		pixelX[i] = random.uniform(0, WINDOW_WIDTH);
+		pixelY[i] = random.uniform(0, WINDOW_HEIGHT);
+	}
+
+	vector<Matrix4f> left(INPUT_COUNT), right(INPUT_COUNT);
+	for (int i = 0; i < INPUT_COUNT; i++)
+	{
+		left[i] = randomMatrix(random);
+		right[i] = randomMatrix(random);
+	}
+
+	vector<Result> results;
+
+	results.push_back(measure("validateMove/legal", samples, [&](int i)
+	{
+		sink += validateMove(boards[i], legalFrom[i], legalTo[i]);
+	}));
+
+	results.push_back(measure("validateMove/random", samples, [&](int i)
+	{
+		sink += validateMove(boards[i], queryFrom[i], queryTo[i]);
+	}));
+
+	results.push_back(measure("hasAnyMove", samples, [&](int i)
+	{
+		sink += hasAnyMove(boards[i]);
+	}));
+
+	results.push_back(measure("evaluateStatus", samples, [&](int i)
+	{
+		sink += evaluateStatus(boards[i]);
+	}));
+
+	results.push_back(measure("makeMove+undoMove", samples, [&](int i)
+	{
+		sink += games[i].makeMove(legalFrom[i], legalTo[i]);
+		sink += games[i].undoMove();
+	}));
+
+	results.push_back(measure("screenToBoard", samples, [&](int i)
+	{
+		Position hole = screenToBoard(pixelX[i], pixelY[i], WINDOW_WIDTH, WINDOW_HEIGHT);
+		sink += hole.row * BOARD_STRIDE + hole.col;
+	}));
+
+	results.push_back(measure("Matrix4f::operator*", samples, [&](int i)
+	{
+		Matrix4f product = left[i] * right[i];
+		sink += floatBits(product.m[i & 3][(i >> 2) & 3]);
+	}));
+
+	results.push_back(measure("Matrix4f::Inverse", samples, [&](int i)
+	{
+		Matrix4f inverse = left[i];
+		inverse.Inverse();
+		sink += floatBits(inverse.m[i & 3][(i >> 2) & 3]);
+	}));
+
+	printJson(seed, samples, results);
+	return 0;
+}
@@ -0,0 +1,595 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "batch_solver.h"
+#include "bitboard.h"
+#include "endgame_tablebase.h"
+#include "minimum_move_solver.h"
+#include "notation.h"
+#include "opening_book.h"
+#include "parallel_solver.h"
+#include "pattern_database.h"
+#include "perft.h"
+#include "position_class.h"
+#include "solvability_db.h"
+#include "solver.h"
+
+using namespace std;
+
+/********************************************************************
+  Headless command-line front end to the engine library
+ */
+
+struct Options
+{
+	Bitboard board;
+	Bitboard target;
+	int threads;
+	int depth;
+	int marbles;
+	int plies;
+	uint64_t budget;
+	string database;
+	string tablebase;
+	string book;
+	string patterns;
+};
+
+const int DEFAULT_PERFT_DEPTH = 9;
+const uint64_t DEFAULT_NODE_BUDGET = 1000000000;
+
+const char *DEFAULT_DATABASE = "data/solvability.db";
+const char *DEFAULT_TABLEBASE = "data/endgame.tb";
+const char *DEFAULT_BOOK = "data/opening.book";
+const char *DEFAULT_PATTERNS = "data/patterns.pdb";
+
+static void printUsage()
+{
+	fprintf(stderr,
+			"usage: marble_cli <command> [options]\n"
+			"\n"
+			"commands:\n"
+			"  solve    find a winning line from the position\n"
+			"  batch    solve every single-vacancy start for every finishing hole in one\n"
+			"           run, probing --tb if given\n"
+			"  bench    time the parallel solver at 1, 2, 4, ... threads\n"
+			"  min-moves\n"
+			"           find a solution with the fewest moves, counting a chain of\n"
+			"           jumps by one marble as one move, within --budget nodes,\n"
+			"           guided by --pdb if given\n"
+			"  build-db enumerate every position reachable from the standard start\n"
+			"           and write the solvability database\n"
+			"  lookup   look the position up in the solvability database, or in the\n"
+			"           opening book with --book\n"
+			"  build-tb write the endgame tablebase for up to --marbles marbles\n"
+			"  build-book\n"
+			"           write the opening book for the first --plies plies of every\n"
+			"           single-vacancy start, probing --tb if given\n"
+			"  build-pdb\n"
+			"           write the pattern databases for min-moves\n"
+			"  perft    count move sequences to each depth up to --depth against\n"
+			"           reference counts, cross-check them through the rules core,\n"
+			"           and time the count on --threads threads\n"
+			"\n"
+			"options:\n"
+			"  --position P   start position (default: the standard start)\n"
+			"  --target R,C   finish with the last marble on this hole (default: anywhere)\n"
+			"  --threads N    worker threads; for bench, the largest count tried\n"
+			"  --depth N      perft depth (default: %d)\n"
+			"  --budget N     positions min-moves may visit, 0 for no limit (default: %llu)\n"
+			"  --db FILE      solvability database (default: %s)\n"
+			"  --marbles N    largest marble count in the tablebase (default: %d)\n"
+			"  --tb FILE      endgame tablebase; solve, batch and build-book probe it\n"
+			"                 (build-tb default: %s)\n"
+			"  --plies N      opening book depth (default: %d)\n"
+			"  --book FILE    opening book (build-book default: %s)\n"
+			"  --pdb FILE     pattern databases (build-pdb default: %s)\n",
+			DEFAULT_PERFT_DEPTH, (unsigned long long)DEFAULT_NODE_BUDGET, DEFAULT_DATABASE, DEFAULT_TABLEBASE_MARBLES, DEFAULT_TABLEBASE, DEFAULT_BOOK_PLIES,
+			DEFAULT_BOOK, DEFAULT_PATTERNS);
+}
+
+static double secondsSince(chrono::steady_clock::time_point start)
+{
+	return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+static bool parseOptions(int argc, char *argv[], Options &options)
+{
+	options.board = START_POSITION;
+	options.target = 0;
+	options.threads = 1;
+	options.depth = DEFAULT_PERFT_DEPTH;
+	options.marbles = DEFAULT_TABLEBASE_MARBLES;
+	options.plies = DEFAULT_BOOK_PLIES;
+	options.budget = DEFAULT_NODE_BUDGET;
+	options.database = DEFAULT_DATABASE;
+
+	for (int i = 2; i < argc; i++)
+	{
+		if (i + 1 >= argc)
+		{
+			fprintf(stderr, "Missing value for '%s'\n", argv[i]);
+			return false;
+		}
+
+		if (strcmp(argv[i], "--position") == 0)
+		{
+			if (!parseBoard(argv[++i], options.board))
+			{
+				fprintf(stderr, "Invalid position '%s'\n", argv[i]);
+				return false;
+			}
+		}
+		else if (strcmp(argv[i], "--target") == 0)
+		{
+			int row, col;
+			if (sscanf(argv[++i], "%d,%d", &row, &col) != 2 || !isBoardHole(row, col))
+			{
+				fprintf(stderr, "Invalid target '%s'\n", argv[i]);
+				return false;
+			}
+			options.target = cellBit(row, col);
+		}
+		else if (strcmp(argv[i], "--threads") == 0)
+		{
+			options.threads = atoi(argv[++i]);
+			if (options.threads < 1)
+			{
+				fprintf(stderr, "Invalid thread count '%s'\n", argv[i]);
+				return false;
+			}
+		}
+		else if (strcmp(argv[i], "--depth") == 0)
+		{
+			options.depth = atoi(argv[++i]);
+			if (options.depth < 1 || options.depth > MAX_GAME_MOVES)
+			{
+				fprintf(stderr, "Invalid depth '%s'\n", argv[i]);
+				return false;
+			}
+		}
+		else if (strcmp(argv[i], "--db") == 0)
+		{
+			options.database = argv[++i];
+		}
+		else if (strcmp(argv[i], "--marbles") == 0)
+		{
+			options.marbles = atoi(argv[++i]);
+			if (options.marbles < 1 || options.marbles > 32)
+			{
+				fprintf(stderr, "Invalid marble count '%s'\n", argv[i]);
+				return false;
+			}
+		}
+		else if (strcmp(argv[i], "--tb") == 0)
+		{
+			options.tablebase = argv[++i];
+		}
+		else if (strcmp(argv[i], "--plies") == 0)
+		{
+			options.plies = atoi(argv[++i]);
+			if (options.plies < 0 || options.plies >= MAX_GAME_MOVES)
+			{
+				fprintf(stderr, "Invalid ply count '%s'\n", argv[i]);
+				return false;
+			}
+		}
+		else if (strcmp(argv[i], "--budget") == 0)
+		{
+			options.budget = strtoull(argv[++i], NULL, 10);
+		}
+		else if (strcmp(argv[i], "--book") == 0)
+		{
+			options.book = argv[++i];
+		}
+		else if (strcmp(argv[i], "--pdb") == 0)
+		{
+			options.patterns = argv[++i];
+		}
+		else
+		{
+			fprintf(stderr, "Unknown option '%s'\n", argv[i]);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static int runSolve(const Options &options)
+{
+	vector<Move> solution;
+	uint64_t nodes;
+	bool won;
+
+	printf("position: %s\n", formatBoard(options.board).c_str());
+
+	if (((options.target ? options.target : VALID_HOLES) & classFinishes(options.board)) == 0)
+	{
+		printf("result:   lost (position class %d cannot finish %s)\n", positionClass(options.board),
+			   options.target ? "on the target" : "with one marble");
+		return 0;
+	}
+
+	EndgameTablebase tablebase;
+	if (!options.tablebase.empty() && !tablebase.open(options.tablebase.c_str()))
+		return 1;
+
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+	if (options.threads > 1)
+	{
+		ParallelSolver solver(options.threads);
+		solver.setTablebase(&tablebase);
+		won = solver.solve(options.board, solution, options.target);
+		nodes = solver.nodes();
+	}
+	else
+	{
+		Solver solver;
+		solver.setTablebase(&tablebase);
+		won = solver.solve(options.board, solution, options.target);
+		nodes = solver.nodes();
+	}
+
+	double seconds = secondsSince(start);
+
+	printf("result:   %s\n", won ? "won" : "lost");
+
+	if (won)
+	{
+		printf("solution:");
+		for (size_t i = 0; i < solution.size(); i++)
+			printf(" %s", formatMove(solution[i]).c_str());
+		printf("\n");
+	}
+
+	printf("nodes:    %llu in %.3f s (%.0f nodes/s)\n", (unsigned long long)nodes, seconds, nodes / seconds);
+	return 0;
+}
+
+static int runBatch(const Options &options)
+{
+	EndgameTablebase tablebase;
+	if (!options.tablebase.empty() && !tablebase.open(options.tablebase.c_str()))
+		return 1;
+
+	BatchSolver solver;
+	solver.setTablebase(&tablebase);
+
+	Bitboard reachable[BOARD_SIZE * BOARD_STRIDE];
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	solver.solveSingleVacancies(reachable);
+	double seconds = secondsSince(start);
+
+	// One line per start: the empty hole, then every hole its last marble can end on
+	int pairs = 0;
+	for (int hole = 0; hole < BOARD_SIZE * BOARD_STRIDE; hole++)
+	{
+		if (!((VALID_HOLES >> hole) & 1))
+			continue;
+
+		printf("%d,%d:", hole / BOARD_STRIDE, hole % BOARD_STRIDE);
+		for (Bitboard finishes = reachable[hole]; finishes; finishes &= finishes - 1)
+		{
+			int finish = __builtin_ctzll(finishes);
+			printf(" %d,%d", finish / BOARD_STRIDE, finish % BOARD_STRIDE);
+		}
+		printf("\n");
+
+		pairs += countMarbles(reachable[hole]);
+	}
+
+	int holes = countMarbles(VALID_HOLES);
+	printf("solvable: %d of %d start/finish pairs\n", pairs, holes * holes);
+	printf("nodes:    %llu in %.3f s (%.0f nodes/s)\n", (unsigned long long)solver.nodes(), seconds, solver.nodes() / seconds);
+	return 0;
+}
+
+static int runMinimumMoves(const Options &options)
+{
+	printf("position: %s\n", formatBoard(options.board).c_str());
+
+	EndgameTablebase tablebase;
+	if (!options.tablebase.empty() && !tablebase.open(options.tablebase.c_str()))
+		return 1;
+
+	PatternDatabase patterns;
+	if (!options.patterns.empty() && !patterns.open(options.patterns.c_str()))
+		return 1;
+
+	MinimumMoveSolver solver;
+	solver.setTablebase(&tablebase);
+	solver.setPatternDatabase(&patterns);
+	solver.setNodeBudget(options.budget);
+
+	// One line when the bound rises and one every PROGRESS_INTERVAL positions in between
+	solver.setProgressCallback([](const MinimumMoveProgress &progress)
+	{
+		printf("bound %2d: %12llu nodes, %8.1f s\n", progress.bound, (unsigned long long)progress.nodes, progress.seconds);
+		fflush(stdout);
+	});
+
+	vector<Move> jumps;
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	int moves = solver.solve(options.board, jumps, options.target);
+	double seconds = secondsSince(start);
+
+	if (moves >= 0)
+	{
+		printf("result:   won in %d moves\n", moves);
+
+		// A jump from where the previous one landed continues the same move
+		printf("solution:");
+		for (size_t i = 0; i < jumps.size(); i++)
+		{
+			bool chained = i > 0 && jumps[i].from.row == jumps[i - 1].to.row && jumps[i].from.col == jumps[i - 1].to.col;
+			if (chained)
+				printf("-%d,%d", jumps[i].to.row, jumps[i].to.col);
+			else
+				printf(" %s", formatMove(jumps[i]).c_str());
+		}
+		printf("\n");
+	}
+	else if (solver.aborted())
+	{
+		printf("result:   budget exhausted; every solution takes at least %d moves\n", solver.bound());
+	}
+	else
+	{
+		printf("result:   lost\n");
+	}
+
+	printf("nodes:    %llu in %.3f s (%.0f nodes/s)\n", (unsigned long long)solver.nodes(), seconds, solver.nodes() / seconds);
+	return 0;
+}
+
+static int runBench(const Options &options)
+{
+	// Scaling past the core count only measures the scheduler, so say how many there are
+	printf("cores:   %u\n", thread::hardware_concurrency());
+	printf("%8s %12s %10s %14s %14s %8s\n", "threads", "nodes", "seconds", "nodes/s", "nodes/s/thread", "speedup");
+	double baseRate = 0.0;
+
+	// Powers of two, always finishing with the requested count
+	vector<int> counts;
+	for (int threads = 1; threads < options.threads; threads *= 2)
+		counts.push_back(threads);
+	counts.push_back(options.threads);
+
+	for (size_t i = 0; i < counts.size(); i++)
+	{
+		int threads = counts[i];
+		ParallelSolver solver(threads);
+		vector<Move> solution;
+
+		chrono::steady_clock::time_point start = chrono::steady_clock::now();
+		solver.solve(options.board, solution, options.target);
+		double seconds = secondsSince(start);
+
+		double rate = solver.nodes() / seconds;
+		if (i == 0)
+			baseRate = rate;
+
+		printf("%8d %12llu %10.3f %14.0f %14.0f %7.2fx\n", threads, (unsigned long long)solver.nodes(), seconds, rate,
+			   rate / threads, rate / baseRate);
+	}
+
+	return 0;
+}
+
+static int runBuildDatabase(const Options &options)
+{
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+	if (!buildSolvabilityDatabase(options.database.c_str(), stdout))
+		return 1;
+
+	printf("wrote %s in %.1f s\n", options.database.c_str(), secondsSince(start));
+	return 0;
+}
+
+static int runBuildTablebase(const Options &options)
+{
+	string fileName = options.tablebase.empty() ? DEFAULT_TABLEBASE : options.tablebase;
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+	if (!buildEndgameTablebase(fileName.c_str(), options.marbles, stdout))
+		return 1;
+
+	printf("wrote %s in %.1f s\n", fileName.c_str(), secondsSince(start));
+	return 0;
+}
+
+static int runBuildBook(const Options &options)
+{
+	string fileName = options.book.empty() ? DEFAULT_BOOK : options.book;
+
+	EndgameTablebase tablebase;
+	if (!options.tablebase.empty() && !tablebase.open(options.tablebase.c_str()))
+		return 1;
+
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+	if (!buildOpeningBook(fileName.c_str(), options.plies, &tablebase, stdout))
+		return 1;
+
+	printf("wrote %s in %.1f s\n", fileName.c_str(), secondsSince(start));
+	return 0;
+}
+
+static int runBuildPatterns(const Options &options)
+{
+	string fileName = options.patterns.empty() ? DEFAULT_PATTERNS : options.patterns;
+
+	if (!buildPatternDatabase(fileName.c_str(), stdout))
+		return 1;
+
+	printf("wrote %s\n", fileName.c_str());
+	return 0;
+}
+
+// Answer from the opening book instead of the database
+static int runBookLookup(const Options &options)
+{
+	OpeningBook book;
+	if (!book.open(options.book.c_str()))
+		return 1;
+
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	bool winnable;
+	Move bestMove;
+	bool found = book.lookup(options.board, winnable, bestMove);
+	double seconds = secondsSince(start);
+
+	if (!found)
+		printf("result:   not in the book (deeper than %d plies, or not from a single-vacancy start)\n", book.plies());
+	else if (winnable)
+		printf("result:   winnable, play %s (%.1f us)\n", formatMove(bestMove).c_str(), seconds * 1e6);
+	else
+		printf("result:   not winnable (%.1f us)\n", seconds * 1e6);
+
+	return 0;
+}
+
+static int runLookup(const Options &options)
+{
+	printf("position: %s\n", formatBoard(options.board).c_str());
+
+	if (!options.book.empty())
+		return runBookLookup(options);
+
+	// Every position in the database shares the standard start's class
+	if (positionClass(options.board) != positionClass(START_POSITION))
+	{
+		printf("result:   not winnable (position class %d, the start is %d)\n", positionClass(options.board),
+			   positionClass(START_POSITION));
+		return 0;
+	}
+
+	SolvabilityDatabase database;
+	if (!database.open(options.database.c_str()))
+		return 1;
+
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	bool winnable = database.isWinnable(options.board);
+	double seconds = secondsSince(start);
+
+	printf("result:   %s (%.1f us)\n", winnable ? "winnable" : "not winnable", seconds * 1e6);
+	return 0;
+}
+
+static int runPerft(const Options &options)
+{
+	bool standard = options.board == START_POSITION;
+	bool mismatch = false;
+	uint64_t nodes = 0;
+
+	printf("position: %s\n", formatBoard(options.board).c_str());
+	printf("%-22s %16s %10s %14s %s\n", "depth", "nodes", "seconds", "nodes/s", "check");
+
+	// One thread, every depth, against the reference counts where they exist
+	for (int depth = 1; depth <= options.depth; depth++)
+	{
+		chrono::steady_clock::time_point start = chrono::steady_clock::now();
+		nodes = perft(options.board, depth);
+		double seconds = secondsSince(start);
+
+		const char *check = "-";
+		if (standard && depth < STANDARD_PERFT_DEPTHS)
+		{
+			check = nodes == STANDARD_PERFT[depth] ? "ok" : "MISMATCH";
+			mismatch = mismatch || nodes != STANDARD_PERFT[depth];
+		}
+
+		printf("%-22d %16llu %10.3f %14.0f %s\n", depth, (unsigned long long)nodes, seconds, nodes / seconds, check);
+	}
+
+	// At full depth, the rules core's hole-by-hole validation and the threaded split must agree
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	uint64_t naive = perftNaive(options.board, options.depth);
+	double seconds = secondsSince(start);
+
+	printf("%-22s %16llu %10.3f %14.0f %s\n", "rules core, 1 thread", (unsigned long long)naive, seconds,
+		   naive / seconds, naive == nodes ? "ok" : "MISMATCH");
+
+	start = chrono::steady_clock::now();
+	uint64_t parallel = parallelPerft(options.board, options.depth, options.threads);
+	seconds = secondsSince(start);
+
+	string label = to_string(options.threads) + (options.threads == 1 ? " thread" : " threads");
+	printf("%-22s %16llu %10.3f %14.0f %s\n", label.c_str(), (unsigned long long)parallel, seconds,
+		   parallel / seconds, parallel == nodes ? "ok" : "MISMATCH");
+
+	mismatch = mismatch || naive != nodes || parallel != nodes;
+	return mismatch ? 1 : 0;
+}
+
+// Commands that time thread scaling default to every core the machine has
+static void defaultToAllCores(int argc, char *argv[], Options &options)
+{
+	for (int i = 2; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--threads") == 0)
+			return;
+	}
+
+	options.threads = max(1u, thread::hardware_concurrency());
+}
+
+int main(int argc, char *argv[])
+{
+	if (argc < 2)
+	{
+		printUsage();
+		return 1;
+	}
+
+	Options options;
+	if (!parseOptions(argc, argv, options))
+		return 1;
+
+	if (strcmp(argv[1], "solve") == 0)
+		return runSolve(options);
+
+	if (strcmp(argv[1], "batch") == 0)
+		return runBatch(options);
+
+	if (strcmp(argv[1], "bench") == 0)
+	{
+		defaultToAllCores(argc, argv, options);
+		return runBench(options);
+	}
+
+	if (strcmp(argv[1], "min-moves") == 0)
+		return runMinimumMoves(options);
+
+	if (strcmp(argv[1], "perft") == 0)
+	{
+		defaultToAllCores(argc, argv, options);
+		return runPerft(options);
+	}
+
+	if (strcmp(argv[1], "build-db") == 0)
+		return runBuildDatabase(options);
+
+	if (strcmp(argv[1], "lookup") == 0)
+		return runLookup(options);
+
+	if (strcmp(argv[1], "build-tb") == 0)
+		return runBuildTablebase(options);
+
+	if (strcmp(argv[1], "build-book") == 0)
+		return runBuildBook(options);
+
+	if (strcmp(argv[1], "build-pdb") == 0)
+		return runBuildPatterns(options);
+
+	printUsage();
+	return 1;
+}